@@ -5,7 +5,7 @@ int main(int arg, char* args[])
    SDL_Surface* hello = NULL;
    SDL_Surface* screen = NULL;
 
-   SDL_Init(SDL_INIT_EVERYTHING);
+   SDL_Init(SDL_INIT_VIDEO);
 
    screen = SDL_SetVideoMode(640, 480, 32, SDL_SWSURFACE);
 
@@ -1,7 +1,7 @@
 #include "SDL/SDL.h"
 
 int main(int argc, char* args[]) {
-	SDL_Init(SDL_INIT_EVERYTHING);
+	SDL_Init(SDL_INIT_VIDEO);
 	SDL_Quit();
 	return 0;
 }
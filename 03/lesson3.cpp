@@ -33,7 +33,7 @@ void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination)
 
 int main(int argc, char* args[])
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return 1;
    }
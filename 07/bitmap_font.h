@@ -0,0 +1,281 @@
+#ifndef BITMAP_FONT_H
+#define BITMAP_FONT_H
+
+#include "SDL/SDL.h"
+#include <string>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// A baked font is one size of a TrueType font as fontbake left it: a
+// FontHeader, a FontGlyph for every printable ASCII character, the non-zero
+// kerning pairs sorted by (previous, current), and then an atlas of glyph
+// bitmaps with one byte per pixel, 1 where there is ink. BitmapFont maps the
+// file and renders from it the way TTF_RenderText_Solid does, without
+// FreeType.
+const char FONT_MAGIC[4] = { 'B', 'F', 'N', 'T' };
+const int FONT_VERSION = 1;
+const int FONT_FIRST = 32;
+const int FONT_LAST = 126;
+const int FONT_GLYPHS = FONT_LAST - FONT_FIRST + 1;
+
+struct FontHeader
+{
+   char magic[4];
+   Uint32 version;
+   Sint32 ascent, height;
+   Uint32 kerningPairs;
+   Uint32 atlasWidth, atlasHeight;
+};
+
+struct FontGlyph
+{
+   // where the bitmap is in the atlas
+   Sint16 x, y, w, h;
+   Sint16 minx, maxx, maxy, advance;
+};
+
+struct FontKerning
+{
+   Uint8 previous, current;
+   Sint16 amount;
+};
+
+class BitmapFont
+{
+   private:
+      void *data;
+      size_t size;
+      const FontHeader *header;
+      const FontGlyph *glyphs;
+      const FontKerning *kerning;
+      const Uint8 *atlas;
+   public:
+      BitmapFont();
+      ~BitmapFont();
+      bool open(std::string filename, std::string source = "");
+      void close();
+      bool is_open();
+      int kern(int previous, int current);
+      int width(const char *text);
+      int height();
+      SDL_Surface *render(const char *text, SDL_Color color);
+};
+
+BitmapFont::BitmapFont()
+{
+   data = NULL;
+   size = 0;
+   header = NULL;
+   glyphs = NULL;
+   kerning = NULL;
+   atlas = NULL;
+}
+
+BitmapFont::~BitmapFont()
+{
+   close();
+}
+
+// A file older than source, the font it was baked from, is left alone as
+// stale, so a changed font is drawn by SDL_ttf until it is baked again.
+bool BitmapFont::open(std::string filename, std::string source)
+{
+   close();
+
+   int fd = ::open(filename.c_str(), O_RDONLY);
+   if (fd == -1)
+   {
+      return false;
+   }
+
+   struct stat info;
+   if ((fstat(fd, &info) == -1) || (info.st_size < (off_t)sizeof(FontHeader)))
+   {
+      ::close(fd);
+      return false;
+   }
+
+   struct stat original;
+   if ((source.empty() == false) && (stat(source.c_str(), &original) == 0) && (original.st_mtime > info.st_mtime))
+   {
+      ::close(fd);
+      return false;
+   }
+
+   void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if (mapped == MAP_FAILED)
+   {
+      return false;
+   }
+
+   const FontHeader *found = (const FontHeader*)mapped;
+   size_t tables = sizeof(FontHeader) + FONT_GLYPHS * sizeof(FontGlyph) + (size_t)found->kerningPairs * sizeof(FontKerning);
+   if ((memcmp(found->magic, FONT_MAGIC, 4) != 0) || (found->version != FONT_VERSION) ||
+       (tables + (size_t)found->atlasWidth * found->atlasHeight > (size_t)info.st_size))
+   {
+      munmap(mapped, info.st_size);
+      return false;
+   }
+
+   data = mapped;
+   size = info.st_size;
+   header = found;
+   glyphs = (const FontGlyph*)(header + 1);
+   kerning = (const FontKerning*)(glyphs + FONT_GLYPHS);
+   atlas = (const Uint8*)mapped + tables;
+   return true;
+}
+
+void BitmapFont::close()
+{
+   if (data != NULL)
+   {
+      munmap(data, size);
+   }
+   data = NULL;
+   size = 0;
+   header = NULL;
+}
+
+bool BitmapFont::is_open()
+{
+   return header != NULL;
+}
+
+// the extra space between two glyphs, on top of the first one's advance
+int BitmapFont::kern(int previous, int current)
+{
+   int low = 0, high = (int)header->kerningPairs - 1;
+   while (low <= high)
+   {
+      int middle = (low + high) / 2;
+      int order = (kerning[middle].previous - previous) * 256 + (kerning[middle].current - current);
+      if (order == 0)
+      {
+         return kerning[middle].amount;
+      }
+      if (order < 0)
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle - 1;
+      }
+   }
+   return 0;
+}
+
+// the same as the width TTF_SizeText would give
+int BitmapFont::width(const char *text)
+{
+   int pen = 0, left = 0, right = 0, previous = 0;
+   for (const char *c = text; *c != '\0'; c++)
+   {
+      int ch = (unsigned char)*c;
+      if ((ch < FONT_FIRST) || (ch > FONT_LAST))
+      {
+         continue;
+      }
+      if (previous != 0)
+      {
+         pen += kern(previous, ch);
+      }
+      const FontGlyph &glyph = glyphs[ch - FONT_FIRST];
+      if (pen + glyph.minx < left)
+      {
+         left = pen + glyph.minx;
+      }
+      int edge = pen + (glyph.advance > glyph.maxx ? glyph.advance : glyph.maxx);
+      if (edge > right)
+      {
+         right = edge;
+      }
+      pen += glyph.advance;
+      previous = ch;
+   }
+   return right - left;
+}
+
+int BitmapFont::height()
+{
+   return header->height;
+}
+
+// Makes the same 8 bit, colorkeyed surface TTF_RenderText_Solid would, or
+// NULL for text with no width. Characters outside 32..126 are skipped.
+SDL_Surface *BitmapFont::render(const char *text, SDL_Color color)
+{
+   int w = width(text);
+   if (w <= 0)
+   {
+      return NULL;
+   }
+
+   SDL_Surface *surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, header->height, 8, 0, 0, 0, 0);
+   if (surface == NULL)
+   {
+      return NULL;
+   }
+
+   // index 0 is the background and the key, 1 is the text
+   SDL_Color colors[2];
+   colors[0].r = 255 - color.r;
+   colors[0].g = 255 - color.g;
+   colors[0].b = 255 - color.b;
+   colors[1] = color;
+   SDL_SetColors(surface, colors, 0, 2);
+   SDL_SetColorKey(surface, SDL_SRCCOLORKEY, 0);
+   SDL_FillRect(surface, NULL, 0);
+
+   int pen = 0, previous = 0;
+   for (const char *c = text; *c != '\0'; c++)
+   {
+      int ch = (unsigned char)*c;
+      if ((ch < FONT_FIRST) || (ch > FONT_LAST))
+      {
+         continue;
+      }
+      if (previous != 0)
+      {
+         pen += kern(previous, ch);
+      }
+      const FontGlyph &glyph = glyphs[ch - FONT_FIRST];
+      // SDL_ttf shifts the whole line right when the first glyph hangs left
+      if ((previous == 0) && (glyph.minx < 0))
+      {
+         pen -= glyph.minx;
+      }
+
+      int top = header->ascent - glyph.maxy;
+      for (int row = 0; row < glyph.h; row++)
+      {
+         int y = top + row;
+         if ((y < 0) || (y >= surface->h))
+         {
+            continue;
+         }
+         const Uint8 *src = atlas + (glyph.y + row) * header->atlasWidth + glyph.x;
+         Uint8 *dst = (Uint8*)surface->pixels + y * surface->pitch;
+         for (int col = 0; col < glyph.w; col++)
+         {
+            int x = pen + glyph.minx + col;
+            if ((x >= 0) && (x < surface->w))
+            {
+               dst[x] |= src[col];
+            }
+         }
+      }
+
+      pen += glyph.advance;
+      previous = ch;
+   }
+
+   return surface;
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+#include "bitmap_font.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using std::cout;
+
+const int FONT_BAKE_ATLAS_WIDTH = 512;
+// far more than any kerning pair at the sizes the lessons use
+const int FONT_BAKE_MAX_KERNING = 64;
+
+// strings a baked font is checked against after it is written
+const char *FONT_BAKE_CHECKS[] = {
+   "The quick brown fox jumps over the lazy dog.",
+   "Up was pressed. Down was pressed. Left was pressed. Right was pressed.",
+   "New High Score! Enter Name: Rank: 1st",
+   "AVAST Ty. WAVE fjord Testing Frame Rate 0123456789"
+};
+
+// What TTF_SizeText gives for two glyphs with kern between them: from the
+// leftmost minx to the rightmost of maxx and advance, over both glyphs and
+// the pen at 0. Either glyph can be the one that sticks out on either side.
+int font_pair_width(const FontGlyph &a, const FontGlyph &b, int kern)
+{
+   int second = a.advance + kern;
+   int left = 0;
+   if (a.minx < left)
+   {
+      left = a.minx;
+   }
+   if (second + b.minx < left)
+   {
+      left = second + b.minx;
+   }
+   int right = a.advance > a.maxx ? a.advance : a.maxx;
+   if (right < 0)
+   {
+      right = 0;
+   }
+   int edge = second + (b.advance > b.maxx ? b.advance : b.maxx);
+   if (edge > right)
+   {
+      right = edge;
+   }
+   return right - left;
+}
+
+// SDL_ttf only hands out kerning by FreeType glyph index, so the pair is
+// measured with TTF_SizeText and the kerning that explains that width is
+// looked for, the smallest one first. A pair whose width is the same
+// whatever the kerning, one glyph inside the other, is left unkerned.
+int measure_kerning(TTF_Font *font, const std::vector<FontGlyph> &glyphs, int previous, int current)
+{
+   char pair[3] = { (char)previous, (char)current, 0 };
+   int w = 0;
+   if (TTF_SizeText(font, pair, &w, NULL) == -1)
+   {
+      return 0;
+   }
+   const FontGlyph &a = glyphs[previous - FONT_FIRST];
+   const FontGlyph &b = glyphs[current - FONT_FIRST];
+   for (int amount = 0; amount <= FONT_BAKE_MAX_KERNING; amount++)
+   {
+      // kerning mostly pulls glyphs together, so negative is tried first
+      if (font_pair_width(a, b, -amount) == w)
+      {
+         return -amount;
+      }
+      if (font_pair_width(a, b, amount) == w)
+      {
+         return amount;
+      }
+   }
+   return 0;
+}
+
+bool font_same_surface(SDL_Surface *a, SDL_Surface *b)
+{
+   if ((a == NULL) || (b == NULL) || (a->w != b->w) || (a->h != b->h))
+   {
+      return false;
+   }
+   for (int y = 0; y < a->h; y++)
+   {
+      // only which pixels are ink matters, SDL_ttf uses index 1 as well
+      Uint8 *rowA = (Uint8*)a->pixels + y * a->pitch;
+      Uint8 *rowB = (Uint8*)b->pixels + y * b->pitch;
+      for (int x = 0; x < a->w; x++)
+      {
+         if ((rowA[x] != 0) != (rowB[x] != 0))
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+// Rasterizes the printable ASCII glyphs once and writes them to filename.
+// header is left as written, for anyone who wants to report on it.
+bool bake_font(TTF_Font *font, std::string filename, FontHeader &header)
+{
+   SDL_Color ink = { 255, 255, 255 };
+   std::vector<FontGlyph> glyphs(FONT_GLYPHS);
+   std::vector<SDL_Surface*> bitmaps(FONT_GLYPHS, (SDL_Surface*)NULL);
+   int x = 0, y = 0, shelf = 0;
+   for (int i = 0; i < FONT_GLYPHS; i++)
+   {
+      FontGlyph &glyph = glyphs[i];
+      memset(&glyph, 0, sizeof(glyph));
+
+      int minx, maxx, miny, maxy, advance;
+      if (TTF_GlyphMetrics(font, FONT_FIRST + i, &minx, &maxx, &miny, &maxy, &advance) == -1)
+      {
+         continue;
+      }
+      glyph.minx = minx;
+      glyph.maxx = maxx;
+      glyph.maxy = maxy;
+      glyph.advance = advance;
+
+      bitmaps[i] = TTF_RenderGlyph_Solid(font, FONT_FIRST + i, ink);
+      if (bitmaps[i] == NULL)
+      {
+         continue;
+      }
+
+      // shelves as tall as the tallest glyph on them
+      if (x + bitmaps[i]->w > FONT_BAKE_ATLAS_WIDTH)
+      {
+         x = 0;
+         y += shelf;
+         shelf = 0;
+      }
+      glyph.x = x;
+      glyph.y = y;
+      glyph.w = bitmaps[i]->w;
+      glyph.h = bitmaps[i]->h;
+      x += bitmaps[i]->w;
+      if (bitmaps[i]->h > shelf)
+      {
+         shelf = bitmaps[i]->h;
+      }
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, FONT_MAGIC, 4);
+   header.version = FONT_VERSION;
+   header.ascent = TTF_FontAscent(font);
+   header.height = TTF_FontHeight(font);
+   header.atlasWidth = FONT_BAKE_ATLAS_WIDTH;
+   header.atlasHeight = y + shelf;
+
+   std::vector<Uint8> atlas(header.atlasWidth * header.atlasHeight, 0);
+   for (int i = 0; i < FONT_GLYPHS; i++)
+   {
+      if (bitmaps[i] == NULL)
+      {
+         continue;
+      }
+      SDL_LockSurface(bitmaps[i]);
+      for (int row = 0; row < glyphs[i].h; row++)
+      {
+         Uint8 *src = (Uint8*)bitmaps[i]->pixels + row * bitmaps[i]->pitch;
+         for (int col = 0; col < glyphs[i].w; col++)
+         {
+            atlas[(glyphs[i].y + row) * header.atlasWidth + glyphs[i].x + col] = src[col] != 0 ? 1 : 0;
+         }
+      }
+      SDL_UnlockSurface(bitmaps[i]);
+      SDL_FreeSurface(bitmaps[i]);
+   }
+
+   // in (previous, current) order, which is what BitmapFont searches
+   std::vector<FontKerning> kerning;
+   if (TTF_GetFontKerning(font) != 0)
+   {
+      for (int previous = FONT_FIRST; previous <= FONT_LAST; previous++)
+      {
+         for (int current = FONT_FIRST; current <= FONT_LAST; current++)
+         {
+            int amount = measure_kerning(font, glyphs, previous, current);
+            if (amount != 0)
+            {
+               FontKerning pair;
+               pair.previous = previous;
+               pair.current = current;
+               pair.amount = amount;
+               kerning.push_back(pair);
+            }
+         }
+      }
+   }
+   header.kerningPairs = kerning.size();
+
+   FILE *file = fopen(filename.c_str(), "wb");
+   if (file == NULL)
+   {
+      return false;
+   }
+   bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+   ok = ok && (fwrite(&glyphs[0], sizeof(FontGlyph), FONT_GLYPHS, file) == (size_t)FONT_GLYPHS);
+   ok = ok && (kerning.empty() || (fwrite(&kerning[0], sizeof(FontKerning), kerning.size(), file) == kerning.size()));
+   ok = ok && (atlas.empty() || (fwrite(&atlas[0], atlas.size(), 1, file) == 1));
+   if (fclose(file) != 0)
+   {
+      ok = false;
+   }
+   return ok;
+}
+
+// Reads back a baked font and holds it against SDL_ttf, giving how many of
+// the check strings come out differently, or -1 if it can't be read.
+int check_baked_font(TTF_Font *font, std::string filename)
+{
+   BitmapFont baked;
+   if (baked.open(filename) == false)
+   {
+      return -1;
+   }
+
+   SDL_Color ink = { 255, 255, 255 };
+   int failed = 0;
+   for (size_t i = 0; i < sizeof(FONT_BAKE_CHECKS) / sizeof(FONT_BAKE_CHECKS[0]); i++)
+   {
+      SDL_Surface *expected = TTF_RenderText_Solid(font, FONT_BAKE_CHECKS[i], ink);
+      SDL_Surface *actual = baked.render(FONT_BAKE_CHECKS[i], ink);
+      if (font_same_surface(expected, actual) == false)
+      {
+         std::cout << "   " << filename << " differs from TTF_RenderText_Solid: \"" << FONT_BAKE_CHECKS[i] << "\"\n";
+         failed++;
+      }
+      SDL_FreeSurface(expected);
+      SDL_FreeSurface(actual);
+   }
+   baked.close();
+   return failed;
+}
+
+// usage: fontbake font.ttf size output.fnt
+// Rasterizes the printable ASCII glyphs once and writes everything
+// BitmapFont needs to draw them without FreeType. It is run ahead of time,
+// in each lesson directory that draws with lazy.ttf,
+//
+//    ../07/fontbake lazy.ttf 28 lazy28.fnt
+//
+// and the lessons only ever open what it wrote. A bake that doesn't draw
+// the same as SDL_ttf is removed again, so they fall back to SDL_ttf.
+int main(int argc, char* args[])
+{
+   if (argc != 4)
+   {
+      cout << "usage: " << args[0] << " font.ttf size output.fnt\n";
+      return 1;
+   }
+
+   if (SDL_Init(0) == -1)
+   {
+      return 1;
+   }
+
+   if (TTF_Init() == -1)
+   {
+      return 1;
+   }
+
+   TTF_Font *font = TTF_OpenFont(args[1], atoi(args[2]));
+   if (font == NULL)
+   {
+      cout << args[1] << ": " << TTF_GetError() << "\n";
+      return 1;
+   }
+
+   FontHeader header;
+   if (bake_font(font, args[3], header) == false)
+   {
+      cout << args[3] << ": could not write\n";
+      return 1;
+   }
+
+   cout << args[1] << " at " << args[2] << " -> " << args[3] << " (" << header.atlasWidth << "x" << header.atlasHeight
+        << " atlas, " << header.kerningPairs << " kerning pairs)\n";
+
+   // read back what was written and hold it against SDL_ttf
+   int failed = check_baked_font(font, args[3]);
+   if (failed == -1)
+   {
+      cout << args[3] << ": could not read back\n";
+   }
+   if (failed != 0)
+   {
+      remove(args[3]);
+   }
+
+   TTF_CloseFont(font);
+   TTF_Quit();
+   SDL_Quit();
+   return failed == 0 ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "bitmap_font.h"
 #include <string>
 
 const int SCREEN_WIDTH = 640;
@@ -12,6 +13,7 @@ SDL_Surface *message = NULL;
 SDL_Surface *background = NULL;
 SDL_Event event;
 TTF_Font *font = NULL;
+BitmapFont bakedFont;
 SDL_Color textColor = {255, 255, 255};
 
 SDL_Surface *load_image(std::string filename)
@@ -37,21 +39,42 @@ void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination,
    SDL_BlitSurface(source, clip, destination, &offset);
 }
 
-bool init()
+// baked ahead of time with "fontbake lazy.ttf 28 lazy28.fnt", FreeType only
+// starts up when that file is missing or older than lazy.ttf
+bool load_font()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (bakedFont.open("lazy28.fnt", "lazy.ttf") == true)
+   {
+      return true;
+   }
+
+   if (TTF_Init() == -1)
    {
       return false;
    }
+   font = TTF_OpenFont("lazy.ttf", 28);
+   return font != NULL;
+}
 
-   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+SDL_Surface *render_text(const char *text)
+{
+   if (bakedFont.is_open() == true)
+   {
+      return bakedFont.render(text, textColor);
+   }
+   return TTF_RenderText_Solid(font, text, textColor);
+}
 
-   if (screen == NULL)
+bool init()
+{
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
 
-   if (TTF_Init() == -1)
+   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+
+   if (screen == NULL)
    {
       return false;
    }
@@ -64,13 +87,12 @@ bool init()
 bool load_files()
 {
    background = load_image("background.png");
-   font = TTF_OpenFont("lazy.ttf", 28);
 
    if (background == NULL)
    {
       return false;
    }
-   if (font == NULL)
+   if (load_font() == false)
    {
       return false;
    }
@@ -101,7 +123,7 @@ int main(int argc, char* args[])
       return 1;
    }
 
-   message = TTF_RenderText_Solid(font, "The quick brown fox jumps over the lazy dog.", textColor);;
+   message = render_text("The quick brown fox jumps over the lazy dog.");
    
    if (message == NULL)
    {
@@ -1,6 +1,8 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "bitmap_font.h"
+#include "text_cache.h"
 #include <string>
 
 const int SCREEN_WIDTH = 640;
@@ -9,15 +11,12 @@ const int SCREEN_BPP = 32;
 
 SDL_Surface *screen = NULL;
 
-SDL_Surface *upMessage = NULL;
-SDL_Surface *downMessage = NULL;
-SDL_Surface *leftMessage = NULL;
-SDL_Surface *rightMessage = NULL;
 SDL_Surface *message = NULL;
 
 SDL_Surface *background = NULL;
 SDL_Event event;
 TTF_Font *font = NULL;
+BitmapFont bakedFont;
 SDL_Color textColor = {255, 255, 255};
 
 SDL_Surface *load_image(std::string filename)
@@ -43,21 +42,68 @@ void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination,
    SDL_BlitSurface(source, clip, destination, &offset);
 }
 
-bool init()
+// baked ahead of time with "../07/fontbake lazy.ttf 28 lazy28.fnt", FreeType only
+// starts up when that file is missing or older than lazy.ttf
+bool load_font()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (bakedFont.open("lazy28.fnt", "lazy.ttf") == true)
+   {
+      return true;
+   }
+
+   if (TTF_Init() == -1)
    {
       return false;
    }
+   font = TTF_OpenFont("lazy.ttf", 28);
+   return font != NULL;
+}
 
-   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+// whichever font load_font opened, which is all the cache needs to tell them apart
+void *text_font()
+{
+   if (bakedFont.is_open() == true)
+   {
+      return &bakedFont;
+   }
+   return font;
+}
 
-   if (screen == NULL)
+SDL_Surface *render_text(void *face, int style, const char *text, SDL_Color color)
+{
+   if (face == &bakedFont)
+   {
+      // baked plain, which is the only style this lesson asks for
+      return style == TTF_STYLE_NORMAL ? bakedFont.render(text, color) : NULL;
+   }
+   TTF_Font *ttf = (TTF_Font*)face;
+   int previous = TTF_GetFontStyle(ttf);
+   // SDL_ttf drops its glyph cache on every style change, so only on a real one
+   if (previous != style)
+   {
+      TTF_SetFontStyle(ttf, style);
+   }
+   SDL_Surface *surface = TTF_RenderText_Solid(ttf, text, color);
+   if (previous != style)
+   {
+      TTF_SetFontStyle(ttf, previous);
+   }
+   return surface;
+}
+
+// the four messages come to a few kilobytes
+TextCache textCache(64 * 1024, render_text);
+
+bool init()
+{
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
 
-   if (TTF_Init() == -1)
+   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+
+   if (screen == NULL)
    {
       return false;
    }
@@ -70,13 +116,12 @@ bool init()
 bool load_files()
 {
    background = load_image("background.png");
-   font = TTF_OpenFont("lazy.ttf", 28);
 
    if (background == NULL)
    {
       return false;
    }
-   if (font == NULL)
+   if (load_font() == false)
    {
       return false;
    }
@@ -86,7 +131,8 @@ bool load_files()
 void clean_up()
 {
    SDL_FreeSurface(background);
-   SDL_FreeSurface(message);
+   textCache.report();
+   textCache.clear();
    TTF_CloseFont(font);
 
    TTF_Quit();
@@ -107,11 +153,6 @@ int main(int argc, char* args[])
       return 1;
    }
    
-   upMessage = TTF_RenderText_Solid(font, "Up was pressed.", textColor);
-   downMessage = TTF_RenderText_Solid(font, "Down was pressed.", textColor);
-   leftMessage = TTF_RenderText_Solid(font, "Left was pressed.", textColor);
-   rightMessage = TTF_RenderText_Solid(font, "Right was pressed.", textColor);
-
    if (SDL_Flip(screen) == -1)
    {
       return 1;
@@ -120,17 +161,22 @@ int main(int argc, char* args[])
    {
       while (SDL_PollEvent(&event))
       {
+         const char *pressed = NULL;
          if (event.type == SDL_KEYDOWN)
          {
             switch(event.key.keysym.sym)
             {
-               case SDLK_UP: message = upMessage; break;
-               case SDLK_DOWN: message = downMessage; break;
-               case SDLK_LEFT: message = leftMessage; break;
-               case SDLK_RIGHT: message = rightMessage; break;
+               case SDLK_UP: pressed = "Up was pressed."; break;
+               case SDLK_DOWN: pressed = "Down was pressed."; break;
+               case SDLK_LEFT: pressed = "Left was pressed."; break;
+               case SDLK_RIGHT: pressed = "Right was pressed."; break;
                default: ;
             }
          }
+         if (pressed != NULL)
+         {
+            message = textCache.get(text_font(), 0, textColor, pressed);
+         }
          if (event.type == SDL_QUIT)
          {
             quit = true;
@@ -145,6 +191,7 @@ int main(int argc, char* args[])
          {
             return 1;
          }
+         textCache.next_frame();
       }      
    }
    clean_up();
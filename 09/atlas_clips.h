@@ -0,0 +1,26 @@
+// generated by atlas, do not edit
+#ifndef ATLAS_CLIPS_H
+#define ATLAS_CLIPS_H
+
+#include "SDL/SDL.h"
+
+const char ATLAS_IMAGE[] = "atlas.bmp";
+
+enum AtlasClip
+{
+   ATLAS_BUTTON_MOUSEOVER,
+   ATLAS_BUTTON_MOUSEOUT,
+   ATLAS_BUTTON_MOUSEDOWN,
+   ATLAS_BUTTON_MOUSEUP,
+   ATLAS_CLIP_COUNT
+};
+
+const SDL_Rect atlasClips[ATLAS_CLIP_COUNT] =
+{
+   { 0, 0, 320, 240 }, // button_mouseover
+   { 320, 0, 320, 240 }, // button_mouseout
+   { 0, 240, 320, 240 }, // button_mousedown
+   { 320, 240, 320, 240 } // button_mouseup
+};
+
+#endif
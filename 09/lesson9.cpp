@@ -1,5 +1,6 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
+#include "atlas_clips.h"
 #include <string>
 
 const int SCREEN_WIDTH = 640;
@@ -8,30 +9,25 @@ const int SCREEN_BPP = 32;
 
 SDL_Surface *screen = NULL;
 
-SDL_Rect clips[4]; 
-
+// the button states from atlas.txt, packed by lesson 20's atlas tool
 SDL_Surface *button = NULL;
 
-const int CLIP_MOUSEOVER = 0;
-const int CLIP_MOUSEOUT = 1;
-const int CLIP_MOUSEDOWN = 2;
-const int CLIP_MOUSEUP = 3;
-
 SDL_Event event;
 
-void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
+void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, const SDL_Rect* clip = NULL)
 {
    SDL_Rect offset;
    offset.x = x;
    offset.y = y;
-   SDL_BlitSurface(source, clip, destination, &offset);
+   // SDL 1.2 only reads the source rect, it just isn't declared const
+   SDL_BlitSurface(source, const_cast<SDL_Rect*>(clip), destination, &offset);
 }
 
 class Button
 {
    private:
    SDL_Rect box;
-   SDL_Rect* clip;
+   const SDL_Rect* clip;
 
    public:
    Button(int x, int y, int w, int h);
@@ -47,7 +43,7 @@ Button::Button(int x, int y, int w, int h)
    box.h = h;
 
    // set default sprite
-   clip = &clips[CLIP_MOUSEOUT];
+   clip = &atlasClips[ATLAS_BUTTON_MOUSEOUT];
 }
 
 void Button::handle_events()
@@ -60,11 +56,11 @@ void Button::handle_events()
 
       if ((x > box.x) && (x < box.x + box.w) && (y > box.y) && (y < box.y + box.h))
       {
-         clip = &clips[CLIP_MOUSEOVER];
+         clip = &atlasClips[ATLAS_BUTTON_MOUSEOVER];
       }
       else 
       {
-         clip = &clips[CLIP_MOUSEOUT];
+         clip = &atlasClips[ATLAS_BUTTON_MOUSEOUT];
       }
    }
    if (event.type == SDL_MOUSEBUTTONDOWN)
@@ -76,7 +72,7 @@ void Button::handle_events()
 
          if ((x > box.x) && (x < box.x + box.w) && (y > box.y) && (y < box.y + box.h))
          {
-            clip = &clips[CLIP_MOUSEDOWN];
+            clip = &atlasClips[ATLAS_BUTTON_MOUSEDOWN];
          }
       }
    }
@@ -89,7 +85,7 @@ void Button::handle_events()
 
          if ((x > box.x) && (x < box.x + box.w) && (y > box.y) && (y < box.y + box.h))
          {
-            clip = &clips[CLIP_MOUSEUP];
+            clip = &atlasClips[ATLAS_BUTTON_MOUSEUP];
          }
       }
    }
@@ -100,29 +96,6 @@ void Button::show()
    apply_surface(box.x, box.y, button, screen, clip);
 }
 
-void set_clips()
-{
-   clips[CLIP_MOUSEOVER].x = 0;
-   clips[CLIP_MOUSEOVER].y = 0;
-   clips[CLIP_MOUSEOVER].w = 320;
-   clips[CLIP_MOUSEOVER].h = 240;
-
-   clips[CLIP_MOUSEOUT].x = 320;
-   clips[CLIP_MOUSEOUT].y = 0;
-   clips[CLIP_MOUSEOUT].w = 320;
-   clips[CLIP_MOUSEOUT].h = 240;
-
-   clips[CLIP_MOUSEDOWN].x = 0;
-   clips[CLIP_MOUSEDOWN].y = 240;
-   clips[CLIP_MOUSEDOWN].w = 320;
-   clips[CLIP_MOUSEDOWN].h = 240;
-                                                   
-   clips[CLIP_MOUSEUP].x = 320;
-   clips[CLIP_MOUSEUP].y = 240;
-   clips[CLIP_MOUSEUP].w = 320;
-   clips[CLIP_MOUSEUP].h = 240;
-}
-
 SDL_Surface *load_image(std::string filename)
 {
    SDL_Surface* loadedImage = NULL;
@@ -140,7 +113,7 @@ SDL_Surface *load_image(std::string filename)
 
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -159,7 +132,7 @@ bool init()
 
 bool load_files()
 {
-   button = load_image("button.png");
+   button = load_image(ATLAS_IMAGE);
 
    if (button == NULL)
    {
@@ -190,7 +163,6 @@ int main(int argc, char* args[])
       return 1;
    }
    
-   set_clips();
    Button myButton(170, 120, 320, 240);
 
    while(quit == false)
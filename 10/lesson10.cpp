@@ -1,6 +1,8 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "bitmap_font.h"
+#include "text_cache.h"
 #include <string>
 
 const int SCREEN_WIDTH = 640;
@@ -10,12 +12,9 @@ const int SCREEN_BPP = 32;
 SDL_Surface *screen = NULL;
 SDL_Surface *background = NULL;
 TTF_Font *font = NULL;
+BitmapFont bakedFont;
 SDL_Event event;
 SDL_Color textColor = {0, 0, 0};
-SDL_Surface *up = NULL;
-SDL_Surface *down = NULL;
-SDL_Surface *left = NULL;
-SDL_Surface *right = NULL;
 
 void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
 {
@@ -40,17 +39,64 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
-bool init()
+// baked ahead of time with "../07/fontbake lazy.ttf 28 lazy28.fnt", FreeType only
+// starts up when that file is missing or older than lazy.ttf
+bool load_font()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (bakedFont.open("lazy28.fnt", "lazy.ttf") == true)
    {
-      return false;
+      return true;
    }
 
    if (TTF_Init() == -1)
    {
       return false;
    }
+   font = TTF_OpenFont("lazy.ttf", 28);
+   return font != NULL;
+}
+
+// whichever font load_font opened, which is all the cache needs to tell them apart
+void *text_font()
+{
+   if (bakedFont.is_open() == true)
+   {
+      return &bakedFont;
+   }
+   return font;
+}
+
+SDL_Surface *render_text(void *face, int style, const char *text, SDL_Color color)
+{
+   if (face == &bakedFont)
+   {
+      // baked plain, which is the only style this lesson asks for
+      return style == TTF_STYLE_NORMAL ? bakedFont.render(text, color) : NULL;
+   }
+   TTF_Font *ttf = (TTF_Font*)face;
+   int previous = TTF_GetFontStyle(ttf);
+   // SDL_ttf drops its glyph cache on every style change, so only on a real one
+   if (previous != style)
+   {
+      TTF_SetFontStyle(ttf, style);
+   }
+   SDL_Surface *surface = TTF_RenderText_Solid(ttf, text, color);
+   if (previous != style)
+   {
+      TTF_SetFontStyle(ttf, previous);
+   }
+   return surface;
+}
+
+// the four labels come to a few kilobytes
+TextCache textCache(64 * 1024, render_text);
+
+bool init()
+{
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return false;
+   }
 
    screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
 
@@ -72,10 +118,9 @@ bool load_files()
       return 1;
    }
 
-   font = TTF_OpenFont("lazy.ttf", 28);
-   if (font == NULL)
+   if (load_font() == false)
    {
-      return 1;
+      return false;
    }
 
    return true;
@@ -84,10 +129,8 @@ bool load_files()
 void clean_up()
 {
    SDL_FreeSurface(background);
-   SDL_FreeSurface(up);
-   SDL_FreeSurface(down);
-   SDL_FreeSurface(left);
-   SDL_FreeSurface(right);
+   textCache.report();
+   textCache.clear();
 
    TTF_Quit();
    SDL_Quit();
@@ -107,11 +150,6 @@ int main(int argc, char* args[])
       return 1;
    }
 
-   up = TTF_RenderText_Solid(font, "Up", textColor);
-   down = TTF_RenderText_Solid(font, "Down", textColor);
-   left = TTF_RenderText_Solid(font, "Left", textColor);
-   right = TTF_RenderText_Solid(font, "Right", textColor);
-   
    while(quit == false)
    {
       while (SDL_PollEvent(&event))
@@ -122,24 +160,28 @@ int main(int argc, char* args[])
          }
       }
 
-
       apply_surface(0, 0, background, screen);
       Uint8 *keystates = SDL_GetKeyState(NULL);
       
+      // asking every frame is a lookup once each label has been drawn
       if (keystates[SDLK_UP])
       {
+         SDL_Surface *up = textCache.get(text_font(), 0, textColor, "Up");
          apply_surface((SCREEN_WIDTH - up->w) / 2, (SCREEN_HEIGHT / 2 - up->h) / 2, up, screen);
       }
       if (keystates[SDLK_DOWN])
       {
+         SDL_Surface *down = textCache.get(text_font(), 0, textColor, "Down");
          apply_surface((SCREEN_WIDTH - down->w) / 2, (SCREEN_HEIGHT / 2 - down->h) / 2 + (SCREEN_HEIGHT / 2), down, screen);
       }
       if (keystates[SDLK_LEFT])
       {
+         SDL_Surface *left = textCache.get(text_font(), 0, textColor, "Left");
          apply_surface((SCREEN_WIDTH / 2 - left->w) / 2, (SCREEN_HEIGHT - left->h) / 2, left, screen);
       }
       if (keystates[SDLK_RIGHT])
       {
+         SDL_Surface *right = textCache.get(text_font(), 0, textColor, "Right");
          apply_surface((SCREEN_WIDTH /  2 - right->w) / 2 + (SCREEN_WIDTH / 2), (SCREEN_HEIGHT - right->h) / 2, right, screen);
       }
      
@@ -147,6 +189,7 @@ int main(int argc, char* args[])
       {
          return 1;
       }
+      textCache.next_frame();
    }
    clean_up();
 
@@ -0,0 +1,219 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include "SDL/SDL.h"
+#include <string>
+#include <map>
+#include <list>
+#include <iostream>
+
+// makes the surface for one string in one TTF_STYLE_ style, NULL if it can't
+typedef SDL_Surface *(*TextRenderer)(void *font, int style, const char *text, SDL_Color color);
+
+// Keeps rendered strings so code can ask for the same text every frame and
+// only pay for rasterizing it once. Entries are keyed by font, style, color
+// and the string itself; a font handle already stands for one face at one
+// size, and strings whose keys hash the same sit side by side. Once the
+// surfaces go over the byte budget the least recently used are freed, but
+// never one handed out since the last next_frame(), so a surface from get()
+// stays valid at least until then.
+class TextCache
+{
+   private:
+      struct Entry
+      {
+         void *font;
+         int style;
+         Uint32 color;
+         std::string text;
+         SDL_Surface *surface;
+         int bytes;
+         Uint64 key;
+         Uint32 lastFrame;
+      };
+      TextRenderer render;
+      // least recently used first, so eviction never has to search
+      std::list<Entry> recent;
+      typedef std::multimap<Uint64, std::list<Entry>::iterator> Index;
+      Index entries;
+      int budget;
+      int resident;
+      Uint32 frame;
+      int hits, misses, evictions;
+      static Uint64 hash(void *font, int style, Uint32 color, const char *text);
+      void trim();
+   public:
+      TextCache(int budgetBytes, TextRenderer renderer);
+      ~TextCache();
+      SDL_Surface *get(void *font, int style, SDL_Color color, const char *text);
+      void next_frame();
+      void set_budget(int budgetBytes);
+      void clear();
+      int get_hits();
+      int get_misses();
+      int get_evictions();
+      int get_resident_bytes();
+      void report();
+};
+
+TextCache::TextCache(int budgetBytes, TextRenderer renderer)
+{
+   render = renderer;
+   budget = budgetBytes;
+   resident = 0;
+   frame = 0;
+   hits = 0;
+   misses = 0;
+   evictions = 0;
+}
+
+TextCache::~TextCache()
+{
+   clear();
+}
+
+// FNV-1a over the whole key, so a lookup never has to build a string
+Uint64 TextCache::hash(void *font, int style, Uint32 color, const char *text)
+{
+   Uint64 h = 14695981039346656037ULL;
+   Uint64 fields[3] = { (Uint64)(size_t)font, (Uint64)style, (Uint64)color };
+   const Uint8 *bytes = (const Uint8*)fields;
+   for (size_t i = 0; i < sizeof(fields); i++)
+   {
+      h = (h ^ bytes[i]) * 1099511628211ULL;
+   }
+   for (const char *c = text; *c != '\0'; c++)
+   {
+      h = (h ^ (Uint8)*c) * 1099511628211ULL;
+   }
+   return h;
+}
+
+SDL_Surface *TextCache::get(void *font, int style, SDL_Color color, const char *text)
+{
+   Uint32 packed = (color.r << 16) | (color.g << 8) | color.b;
+   Uint64 key = hash(font, style, packed, text);
+
+   // nearly always one entry, but a colliding one may have been handed out
+   // this frame and can't be dropped to make room
+   std::pair<Index::iterator, Index::iterator> found = entries.equal_range(key);
+   for (Index::iterator i = found.first; i != found.second; i++)
+   {
+      Entry &entry = *i->second;
+      if ((entry.font == font) && (entry.style == style) && (entry.color == packed) && (entry.text == text))
+      {
+         entry.lastFrame = frame;
+         recent.splice(recent.end(), recent, i->second);
+         hits++;
+         return entry.surface;
+      }
+   }
+
+   misses++;
+   SDL_Surface *surface = render(font, style, text, color);
+   if (surface == NULL)
+   {
+      return NULL;
+   }
+
+   Entry entry;
+   entry.font = font;
+   entry.style = style;
+   entry.color = packed;
+   entry.text = text;
+   entry.surface = surface;
+   entry.bytes = sizeof(SDL_Surface) + surface->h * surface->pitch;
+   if (surface->format->palette != NULL)
+   {
+      entry.bytes += surface->format->palette->ncolors * sizeof(SDL_Color);
+   }
+   entry.key = key;
+   entry.lastFrame = frame;
+   recent.push_back(entry);
+   entries.insert(std::make_pair(key, --recent.end()));
+   resident += entry.bytes;
+
+   trim();
+   return surface;
+}
+
+void TextCache::trim()
+{
+   while ((resident > budget) && (recent.empty() == false))
+   {
+      // everything after the oldest was used later, so if it was handed out
+      // this frame so was the rest, and the budget will have to wait
+      std::list<Entry>::iterator oldest = recent.begin();
+      if (oldest->lastFrame == frame)
+      {
+         return;
+      }
+
+      std::pair<Index::iterator, Index::iterator> found = entries.equal_range(oldest->key);
+      for (Index::iterator i = found.first; i != found.second; i++)
+      {
+         if (i->second == oldest)
+         {
+            entries.erase(i);
+            break;
+         }
+      }
+      resident -= oldest->bytes;
+      SDL_FreeSurface(oldest->surface);
+      recent.erase(oldest);
+      evictions++;
+   }
+}
+
+// surfaces from earlier frames may be freed from here on
+void TextCache::next_frame()
+{
+   frame++;
+   trim();
+}
+
+void TextCache::set_budget(int budgetBytes)
+{
+   budget = budgetBytes;
+   trim();
+}
+
+// frees every surface, whether or not it was handed out this frame
+void TextCache::clear()
+{
+   for (std::list<Entry>::iterator i = recent.begin(); i != recent.end(); i++)
+   {
+      SDL_FreeSurface(i->surface);
+   }
+   recent.clear();
+   entries.clear();
+   resident = 0;
+}
+
+int TextCache::get_hits()
+{
+   return hits;
+}
+
+int TextCache::get_misses()
+{
+   return misses;
+}
+
+int TextCache::get_evictions()
+{
+   return evictions;
+}
+
+int TextCache::get_resident_bytes()
+{
+   return resident;
+}
+
+void TextCache::report()
+{
+   std::cout << "text cache: " << hits << " hits, " << misses << " misses, " << evictions << " evictions, "
+             << entries.size() << " strings in " << resident << " of " << budget << " bytes\n";
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_mixer.h"
+#include "audio_device.h"
+#include "audio_mixer.h"
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+using std::cout;
+
+const int TRIGGERS = 20;
+// scheduling slack on top of AUDIO_PROBE_BUDGET_MS, for the sleeps overrunning
+const int PROBE_SLACK_MS = 100;
+
+bool listed(const int *values, size_t count, int value)
+{
+   for (size_t i = 0; i < count; i++)
+   {
+      if (values[i] == value)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+// usage: audio_check [driver]
+// Opens an AudioDevice on SDL's dummy audio driver, or the one given, e.g.
+// disk, with lesson 11's mixer as its source, and checks what it settled on:
+// a spec from the candidate lists or the fallback, that SDL really opened,
+// found inside the probe budget. Then it plays a short sound every few
+// buffers and checks that every trigger was measured and that each
+// latency is at least the buffer and no more than three of them.
+int main(int argc, char* args[])
+{
+   std::string driver = std::string("SDL_AUDIODRIVER=") + (argc > 1 ? args[1] : "dummy");
+   SDL_putenv((char*)driver.c_str());
+   if (SDL_Init(SDL_INIT_AUDIO) == -1)
+   {
+      cout << "SDL_Init: " << SDL_GetError() << "\n";
+      return 1;
+   }
+
+   Mixer mixer;
+   AudioDevice audio;
+   audio.set_source(Mixer::mix_callback, &mixer);
+   audio.set_probe_load(Mixer::load_callback, &mixer);
+   if (audio.open() == false)
+   {
+      cout << "open: " << Mix_GetError() << "\n";
+      SDL_Quit();
+      return 1;
+   }
+
+   bool ok = true;
+   int frequency = audio.get_frequency();
+   int chunk = audio.get_chunk();
+   int gotFrequency, gotChannels;
+   Uint16 gotFormat;
+   Mix_QuerySpec(&gotFrequency, &gotFormat, &gotChannels);
+   cout << "driver " << driver.substr(driver.find('=') + 1) << ": " << frequency << " Hz, " << chunk << " sample buffer, found in "
+        << audio.get_probe_ms() << " ms\n";
+
+   bool fallback = (frequency == 22050) && (chunk == 4096);
+   if ((fallback == false) && ((listed(AUDIO_FREQUENCIES, sizeof(AUDIO_FREQUENCIES) / sizeof(AUDIO_FREQUENCIES[0]), frequency) == false) ||
+                               (listed(AUDIO_CHUNKS, sizeof(AUDIO_CHUNKS) / sizeof(AUDIO_CHUNKS[0]), chunk) == false)))
+   {
+      cout << "   not a spec open() tries\n";
+      ok = false;
+   }
+   if ((gotFrequency != frequency) || (gotFormat != AUDIO_S16SYS) || (gotChannels != 2))
+   {
+      cout << "   SDL opened " << gotFrequency << " Hz, format " << gotFormat << ", " << gotChannels << " channels\n";
+      ok = false;
+   }
+   if (audio.get_probe_ms() > AUDIO_PROBE_BUDGET_MS + PROBE_SLACK_MS)
+   {
+      cout << "   probing took longer than " << AUDIO_PROBE_BUDGET_MS << " ms\n";
+      ok = false;
+   }
+
+   // a 50 ms click, quiet enough not to matter on a real card
+   std::vector<Sint16> click(frequency / 20 * 2);
+   for (size_t i = 0; i < click.size(); i++)
+   {
+      click[i] = (Sint16)(rand() % 2001 - 1000);
+   }
+   Mix_Chunk chunkData;
+   chunkData.allocated = 0;
+   chunkData.abuf = (Uint8*)&click[0];
+   chunkData.alen = click.size() * sizeof(Sint16);
+   chunkData.volume = MIX_MAX_VOLUME;
+   int sound = mixer.add_sound(&chunkData);
+
+   // each trigger waits out two buffers so the callback has seen the last one
+   int period = chunk * 1000 / frequency + 1;
+   for (int i = 0; i < TRIGGERS; i++)
+   {
+      audio.trigger();
+      mixer.play(sound);
+      SDL_Delay(period * 2 + rand() % period);
+   }
+   SDL_Delay(period * 2);
+
+   cout << "latency: " << audio.get_latency_min() << " to " << audio.get_latency_max() << " samples over "
+        << audio.get_latency_count() << " triggers\n";
+   if (audio.get_latency_count() != TRIGGERS)
+   {
+      cout << "   " << TRIGGERS - audio.get_latency_count() << " triggers never reached a callback\n";
+      ok = false;
+   }
+   if ((audio.get_latency_min() < chunk) || (audio.get_latency_max() > chunk * 3))
+   {
+      cout << "   latency outside " << chunk << " to " << chunk * 3 << " samples\n";
+      ok = false;
+   }
+
+   audio.set_source(NULL, NULL);
+   audio.report();
+   audio.close();
+   SDL_Quit();
+
+   cout << (ok ? "audio device OK\n" : "audio device FAILED\n");
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,314 @@
+#ifndef AUDIO_DEVICE_H
+#define AUDIO_DEVICE_H
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_mixer.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+// tried in this order, the first that keeps up wins
+const int AUDIO_CHUNKS[] = { 256, 512, 1024, 2048, 4096 };
+const int AUDIO_FREQUENCIES[] = { 44100, 48000, 22050 };
+// how long a candidate has to keep up before it is trusted
+const int AUDIO_PROBE_PERIODS = 40;
+const int AUDIO_PROBE_MIN_MS = 60;
+const int AUDIO_PROBE_MAX_MS = 250;
+// all the candidates together, after which the fallback is opened
+const int AUDIO_PROBE_BUDGET_MS = 1000;
+
+// adds frames of 16 bit stereo to what SDL_mixer already mixed
+typedef void (*AudioSource)(void *data, Sint16 *stream, int frames);
+
+// Opens the mixer with the smallest buffer the machine can feed without
+// gaps. Each candidate runs for a few dozen buffer periods while the
+// post-mix hook timestamps every callback; one that falls behind or leaves
+// a gap of more than two periods is closed and the next larger one tried.
+// A candidate that wouldn't finish inside AUDIO_PROBE_BUDGET_MS isn't
+// started, and the 4096 sample buffer the lesson always had is opened
+// instead, so probing never holds up startup for long.
+//
+// The source has to be set before open() so the probe times the callback
+// that will really run. set_probe_load() can stand in for the heaviest mix
+// the source will ever do, and runs instead of it while probing.
+//
+// Once open, trigger() marks the moment a sound is asked for and the next
+// callback turns that into a latency in samples: the wait for the callback
+// plus the buffer it fills, which plays after the one already queued.
+//
+// A source set with set_source() runs in the same callback, after SDL_mixer
+// has done its channels and music.
+class AudioDevice
+{
+   private:
+      int frequency;
+      int chunk;
+      AudioSource source;
+      void *sourceData;
+      AudioSource probeLoad;
+      void *probeData;
+      std::atomic<bool> probing;
+      int probeMillis;
+      std::chrono::steady_clock::time_point origin;
+      // written by the audio thread
+      std::atomic<long long> lastCallback;
+      std::atomic<long long> worstGap;
+      std::atomic<int> callbacks;
+      std::atomic<long long> pendingTrigger;
+      std::atomic<long long> latencyTotal;
+      std::atomic<int> latencyMin, latencyMax, latencyCount;
+      long long micros();
+      static int probe_ms(int tryFrequency, int tryChunk);
+      bool try_open(int tryFrequency, int tryChunk);
+      static void postmix(void *data, Uint8 *stream, int len);
+   public:
+      AudioDevice();
+      bool open();
+      void close();
+      void set_source(AudioSource newSource, void *data);
+      void set_probe_load(AudioSource load, void *data);
+      void trigger();
+      int get_frequency();
+      int get_chunk();
+      int get_probe_ms();
+      int get_latency_count();
+      int get_latency_min();
+      int get_latency_max();
+      void report();
+};
+
+AudioDevice::AudioDevice()
+{
+   frequency = 0;
+   chunk = 0;
+   source = NULL;
+   sourceData = NULL;
+   probeLoad = NULL;
+   probeData = NULL;
+   probing = false;
+   probeMillis = 0;
+   origin = std::chrono::steady_clock::now();
+   lastCallback = 0;
+   worstGap = 0;
+   callbacks = 0;
+   pendingTrigger = -1;
+   latencyTotal = 0;
+   latencyMin = 0;
+   latencyMax = 0;
+   latencyCount = 0;
+}
+
+long long AudioDevice::micros()
+{
+   return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void AudioDevice::postmix(void *data, Uint8 *stream, int len)
+{
+   AudioDevice *device = (AudioDevice*)data;
+   long long now = device->micros();
+
+   long long last = device->lastCallback.exchange(now);
+   if ((last != 0) && (now - last > device->worstGap))
+   {
+      device->worstGap = now - last;
+   }
+   device->callbacks++;
+
+   long long trigger = device->pendingTrigger.exchange(-1);
+   if (trigger >= 0)
+   {
+      int latency = (int)((now - trigger) * device->frequency / 1000000) + device->chunk;
+      device->latencyTotal += latency;
+      if ((device->latencyCount == 0) || (latency < device->latencyMin))
+      {
+         device->latencyMin = latency;
+      }
+      if (latency > device->latencyMax)
+      {
+         device->latencyMax = latency;
+      }
+      device->latencyCount++;
+   }
+
+   if ((device->probing == true) && (device->probeLoad != NULL))
+   {
+      device->probeLoad(device->probeData, (Sint16*)stream, len / 4);
+   }
+   else if (device->source != NULL)
+   {
+      device->source(device->sourceData, (Sint16*)stream, len / 4);
+   }
+}
+
+// how long try_open keeps a candidate open, from the rate it asks for
+int AudioDevice::probe_ms(int tryFrequency, int tryChunk)
+{
+   int period = tryChunk * 1000 / tryFrequency;
+   int probe = period * AUDIO_PROBE_PERIODS;
+   if (probe < AUDIO_PROBE_MIN_MS)
+   {
+      probe = AUDIO_PROBE_MIN_MS;
+   }
+   if (probe > AUDIO_PROBE_MAX_MS)
+   {
+      probe = AUDIO_PROBE_MAX_MS;
+   }
+   return period * 2 + probe;
+}
+
+bool AudioDevice::try_open(int tryFrequency, int tryChunk)
+{
+   if (Mix_OpenAudio(tryFrequency, AUDIO_S16SYS, 2, tryChunk) == -1)
+   {
+      return false;
+   }
+
+   // SDL may hand back something else, the numbers below use what it really is
+   int gotFrequency, gotChannels;
+   Uint16 gotFormat;
+   Mix_QuerySpec(&gotFrequency, &gotFormat, &gotChannels);
+   frequency = gotFrequency;
+   chunk = tryChunk;
+
+   int period = chunk * 1000 / frequency;
+   int probe = probe_ms(frequency, chunk) - period * 2;
+
+   lastCallback = 0;
+   worstGap = 0;
+   callbacks = 0;
+   Mix_SetPostMix(postmix, this);
+   // the first callbacks only fill the device, so they don't count
+   SDL_Delay(period * 2);
+   lastCallback = 0;
+   worstGap = 0;
+   callbacks = 0;
+   SDL_Delay(probe);
+
+   long long expected = (long long)probe * frequency / (1000 * chunk);
+   bool steady = (callbacks * 4 >= expected * 3) && (worstGap <= 2 * 1000000LL * chunk / frequency);
+   if ((gotFormat != AUDIO_S16SYS) || (gotChannels != 2) || (steady == false))
+   {
+      Mix_SetPostMix(NULL, NULL);
+      Mix_CloseAudio();
+      return false;
+   }
+   return true;
+}
+
+bool AudioDevice::open()
+{
+   long long start = micros();
+   probing = true;
+   bool found = false;
+   for (size_t c = 0; (c < sizeof(AUDIO_CHUNKS) / sizeof(AUDIO_CHUNKS[0])) && (found == false); c++)
+   {
+      for (size_t f = 0; (f < sizeof(AUDIO_FREQUENCIES) / sizeof(AUDIO_FREQUENCIES[0])) && (found == false); f++)
+      {
+         long long spent = (micros() - start) / 1000;
+         if (spent + probe_ms(AUDIO_FREQUENCIES[f], AUDIO_CHUNKS[c]) > AUDIO_PROBE_BUDGET_MS)
+         {
+            continue;
+         }
+         found = try_open(AUDIO_FREQUENCIES[f], AUDIO_CHUNKS[c]);
+      }
+   }
+   probing = false;
+   probeMillis = (int)((micros() - start) / 1000);
+   if (found == true)
+   {
+      // what was measured while probing was the probe load
+      worstGap = 0;
+      return true;
+   }
+
+   // nothing kept up, fall back to what the lesson always used
+   frequency = 22050;
+   chunk = 4096;
+   if (Mix_OpenAudio(frequency, AUDIO_S16SYS, 2, chunk) == -1)
+   {
+      return false;
+   }
+   Mix_SetPostMix(postmix, this);
+   return true;
+}
+
+void AudioDevice::close()
+{
+   Mix_SetPostMix(NULL, NULL);
+   Mix_CloseAudio();
+}
+
+// Takes the audio lock so the callback is never halfway through the old
+// source. Pass NULL to stop before freeing whatever the source plays.
+void AudioDevice::set_source(AudioSource newSource, void *data)
+{
+   SDL_LockAudio();
+   source = newSource;
+   sourceData = data;
+   SDL_UnlockAudio();
+}
+
+// Runs in place of the source while open() probes, NULL to probe with the
+// source itself. Set it before open(), like the source.
+void AudioDevice::set_probe_load(AudioSource load, void *data)
+{
+   SDL_LockAudio();
+   probeLoad = load;
+   probeData = data;
+   SDL_UnlockAudio();
+}
+
+// call right where a sound is asked for
+void AudioDevice::trigger()
+{
+   long long expected = -1;
+   // an earlier trigger the audio thread hasn't seen yet keeps its time
+   pendingTrigger.compare_exchange_strong(expected, micros());
+}
+
+int AudioDevice::get_frequency()
+{
+   return frequency;
+}
+
+int AudioDevice::get_chunk()
+{
+   return chunk;
+}
+
+// how long open() spent trying candidates
+int AudioDevice::get_probe_ms()
+{
+   return probeMillis;
+}
+
+// triggers that have been through a callback
+int AudioDevice::get_latency_count()
+{
+   return latencyCount;
+}
+
+// in samples, like report()
+int AudioDevice::get_latency_min()
+{
+   return latencyMin;
+}
+
+int AudioDevice::get_latency_max()
+{
+   return latencyMax;
+}
+
+void AudioDevice::report()
+{
+   std::cout << "audio: " << frequency << " Hz, " << chunk << " sample buffer (" << chunk * 1000.0 / frequency << " ms), "
+             << "found in " << probeMillis << " ms, worst callback gap " << worstGap / 1000.0 << " ms\n";
+   if (latencyCount > 0)
+   {
+      std::cout << "trigger to output: " << latencyMin << " min, " << latencyTotal / latencyCount << " avg, "
+                << latencyMax << " max samples over " << latencyCount << " sounds\n";
+   }
+}
+
+#endif
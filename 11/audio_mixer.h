@@ -0,0 +1,645 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_mixer.h"
+#include <atomic>
+#include <iostream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AUDIO_MIXER_X86
+#include <immintrin.h>
+#endif
+
+// sounds that can play at once, the callback never allocates more
+const int MIXER_VOICES = 512;
+// commands the game can send between two callbacks
+const int MIXER_COMMANDS = 1024;
+// sounds that can be registered with add_sound()
+const int MIXER_SOUNDS = 64;
+// 0 is the least important
+const int MIXER_PRIORITIES = 8;
+// volume steps the quietest voice is looked for in
+const int MIXER_LOUDNESS = 9;
+// handles still in use at once before stop() can miss; a power of two
+const int MIXER_HANDLES = 4096;
+
+// which voice gives way when the pool is full
+enum StealPolicy { MIXER_STEAL_OLDEST, MIXER_STEAL_QUIETEST };
+
+// One thread pushes, one thread pops, neither ever waits. Size has to be a
+// power of two; the indices just keep counting and wrap on their own.
+template <typename T, int Size>
+class SpscRing
+{
+   private:
+      T items[Size];
+      // apart so the two threads don't fight over one cache line
+      alignas(64) std::atomic<unsigned> head;
+      alignas(64) std::atomic<unsigned> tail;
+   public:
+      SpscRing();
+      bool push(const T &item);
+      bool pop(T &item);
+};
+
+template <typename T, int Size>
+SpscRing<T, Size>::SpscRing()
+{
+   head = 0;
+   tail = 0;
+}
+
+// producer only, false when full
+template <typename T, int Size>
+bool SpscRing<T, Size>::push(const T &item)
+{
+   unsigned at = tail.load(std::memory_order_relaxed);
+   if (at - head.load(std::memory_order_acquire) == Size)
+   {
+      return false;
+   }
+   items[at & (Size - 1)] = item;
+   tail.store(at + 1, std::memory_order_release);
+   return true;
+}
+
+// consumer only, false when empty
+template <typename T, int Size>
+bool SpscRing<T, Size>::pop(T &item)
+{
+   unsigned at = head.load(std::memory_order_relaxed);
+   if (at == tail.load(std::memory_order_acquire))
+   {
+      return false;
+   }
+   item = items[at & (Size - 1)];
+   head.store(at + 1, std::memory_order_release);
+   return true;
+}
+
+// adds frames of 16 bit stereo, scaled by volume, into destination
+typedef void (*MixVoice)(Sint16 *destination, const Sint16 *source, int frames, int volume);
+
+// Adds frames of 16 bit stereo, scaled by volume out of MIX_MAX_VOLUME,
+// into destination and clips instead of wrapping. This is the plain version
+// the vector ones have to match sample for sample.
+static void mix_voice_scalar(Sint16 *destination, const Sint16 *source, int frames, int volume)
+{
+   int gain = volume * 32767 / MIX_MAX_VOLUME;
+   for (int i = 0; i < frames * 2; i++)
+   {
+      int sample = volume == MIX_MAX_VOLUME ? source[i] : (source[i] * gain) >> 15;
+      int sum = destination[i] + sample;
+      destination[i] = sum > 32767 ? 32767 : (sum < -32768 ? -32768 : sum);
+   }
+}
+
+// The same with saturating 16 bit adds, 8 samples at a time with SSE2 and
+// 16 with AVX2. SDL makes no promise about the stream's alignment so
+// everything is loaded unaligned.
+#ifdef AUDIO_MIXER_X86
+__attribute__((target("sse2")))
+static void mix_voice_sse2(Sint16 *destination, const Sint16 *source, int frames, int volume)
+{
+   int count = frames * 2;
+   int i = 0;
+   // mulhi keeps the top 16 bits of the product, so the gain goes in one
+   // bit short and the sample one bit up to get the same >> 15
+   bool full = volume == MIX_MAX_VOLUME;
+   __m128i gain16 = _mm_set1_epi16((Sint16)(volume * 32767 / MIX_MAX_VOLUME));
+   for (; i + 8 <= count; i += 8)
+   {
+      __m128i in = _mm_loadu_si128((const __m128i*)(source + i));
+      if (full == false)
+      {
+         // (s * g) >> 15 as (s * g) >> 16 on the low half and one more bit from the high half
+         __m128i low = _mm_mullo_epi16(in, gain16);
+         __m128i high = _mm_mulhi_epi16(in, gain16);
+         in = _mm_or_si128(_mm_slli_epi16(high, 1), _mm_srli_epi16(low, 15));
+      }
+      __m128i out = _mm_loadu_si128((const __m128i*)(destination + i));
+      _mm_storeu_si128((__m128i*)(destination + i), _mm_adds_epi16(out, in));
+   }
+   mix_voice_scalar(destination + i, source + i, (count - i) / 2, volume);
+}
+
+__attribute__((target("avx2")))
+static void mix_voice_avx2(Sint16 *destination, const Sint16 *source, int frames, int volume)
+{
+   int count = frames * 2;
+   int i = 0;
+   bool full = volume == MIX_MAX_VOLUME;
+   __m256i gain16 = _mm256_set1_epi16((Sint16)(volume * 32767 / MIX_MAX_VOLUME));
+   for (; i + 16 <= count; i += 16)
+   {
+      __m256i in = _mm256_loadu_si256((const __m256i*)(source + i));
+      if (full == false)
+      {
+         __m256i low = _mm256_mullo_epi16(in, gain16);
+         __m256i high = _mm256_mulhi_epi16(in, gain16);
+         in = _mm256_or_si256(_mm256_slli_epi16(high, 1), _mm256_srli_epi16(low, 15));
+      }
+      __m256i out = _mm256_loadu_si256((const __m256i*)(destination + i));
+      _mm256_storeu_si256((__m256i*)(destination + i), _mm256_adds_epi16(out, in));
+   }
+   // the last few frames still go 8 samples at a time
+   mix_voice_sse2(destination + i, source + i, (count - i) / 2, volume);
+}
+#endif
+
+static MixVoice mix_voice_select()
+{
+#ifdef AUDIO_MIXER_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+   {
+      return mix_voice_avx2;
+   }
+   if (__builtin_cpu_supports("sse2"))
+   {
+      return mix_voice_sse2;
+   }
+#endif
+   return mix_voice_scalar;
+}
+
+// the widest version this CPU runs, picked once at startup
+static MixVoice mix_voice = mix_voice_select();
+
+// Plays Mix_Chunks on its own instead of through SDL_mixer's channels, so
+// asking for a sound never takes the audio lock. add_sound(), play(),
+// stop() and set_volume() are for the game thread and only queue a
+// command; mix() runs in the audio callback, applies whatever is queued and
+// adds every playing voice on top of the stream. The chunks have to be in
+// the format the device was opened with, 16 bit stereo, which is what
+// Mix_LoadWAV gives.
+//
+// Voices come from a pool fixed at construction. A sound already playing
+// as often as its limit allows replaces its own oldest instance. When the
+// pool is full the new sound takes over the oldest or quietest voice of
+// no higher priority, and is dropped only if every voice outranks it.
+// Each voice sits in intrusive lists by priority, by priority and
+// loudness, and by sound, so none of this ever searches the pool.
+class Mixer
+{
+   private:
+      enum CommandType { MIXER_PLAY, MIXER_STOP, MIXER_VOLUME };
+      struct Command
+      {
+         CommandType type;
+         int handle;
+         int sound;
+         const Sint16 *samples;
+         int frames;
+         int volume;
+         int priority;
+         int maxInstances;
+      };
+      struct Sound
+      {
+         const Sint16 *samples;
+         int frames;
+         int priority;
+         int maxInstances;
+      };
+      // oldest first, -1 for none
+      struct Link
+      {
+         int previous, next;
+      };
+      struct List
+      {
+         int first, last;
+      };
+      struct Voice
+      {
+         int handle;
+         int sound;
+         const Sint16 *samples;
+         int frames;
+         int position;
+         int volume;
+         int priority;
+         // where it is in active
+         int slot;
+         Link age;
+         Link loud;
+         Link same;
+      };
+      SpscRing<Command, MIXER_COMMANDS> commands;
+      StealPolicy policy;
+      int poolSize;
+      std::atomic<int> steals, drops;
+      // touched by the game thread only
+      Sound sounds[MIXER_SOUNDS];
+      int soundCount;
+      int nextHandle;
+      Uint32 rateStart;
+      int rateSteals, rateDrops;
+      int stealsPerSecond, dropsPerSecond;
+      // touched by the audio thread only
+      Voice voices[MIXER_VOICES];
+      int active[MIXER_VOICES];
+      int playing;
+      int freeVoices[MIXER_VOICES];
+      int freeCount;
+      List byAge[MIXER_PRIORITIES];
+      List byLoudness[MIXER_PRIORITIES][MIXER_LOUDNESS];
+      List instances[MIXER_SOUNDS];
+      int instanceCount[MIXER_SOUNDS];
+      int handleVoices[MIXER_HANDLES];
+      void link(List &list, Link Voice::*member, int index);
+      void unlink(List &list, Link Voice::*member, int index);
+      static int loudness(int volume);
+      int choose_victim(int priority);
+      void start(const Command &command);
+      void release(int index);
+      int find(int handle);
+      void apply(const Command &command);
+   public:
+      Mixer(int voiceCount = MIXER_VOICES, StealPolicy stealPolicy = MIXER_STEAL_OLDEST);
+      int add_sound(Mix_Chunk *chunk, int priority = 0, int maxInstances = MIXER_VOICES);
+      int play(int sound, int volume = MIX_MAX_VOLUME);
+      bool stop(int handle);
+      bool set_volume(int handle, int volume);
+      void mix(Sint16 *stream, int frames);
+      int get_playing();
+      int get_steals();
+      int get_drops();
+      bool update_rates(Uint32 ticks);
+      int get_steals_per_second();
+      int get_drops_per_second();
+      void report();
+      static void mix_callback(void *data, Sint16 *stream, int frames);
+      static void load_callback(void *data, Sint16 *stream, int frames);
+};
+
+Mixer::Mixer(int voiceCount, StealPolicy stealPolicy)
+{
+   policy = stealPolicy;
+   poolSize = voiceCount < 1 ? 1 : (voiceCount > MIXER_VOICES ? MIXER_VOICES : voiceCount);
+   steals = 0;
+   drops = 0;
+   soundCount = 0;
+   nextHandle = 1;
+   rateStart = 0;
+   rateSteals = 0;
+   rateDrops = 0;
+   stealsPerSecond = 0;
+   dropsPerSecond = 0;
+
+   playing = 0;
+   // handed out from the end, so voice 0 goes first
+   freeCount = poolSize;
+   for (int i = 0; i < poolSize; i++)
+   {
+      freeVoices[i] = poolSize - 1 - i;
+      voices[i].handle = 0;
+   }
+   List empty = { -1, -1 };
+   for (int p = 0; p < MIXER_PRIORITIES; p++)
+   {
+      byAge[p] = empty;
+      for (int l = 0; l < MIXER_LOUDNESS; l++)
+      {
+         byLoudness[p][l] = empty;
+      }
+   }
+   for (int i = 0; i < MIXER_SOUNDS; i++)
+   {
+      instances[i] = empty;
+      instanceCount[i] = 0;
+   }
+   for (int i = 0; i < MIXER_HANDLES; i++)
+   {
+      handleVoices[i] = -1;
+   }
+}
+
+// Registers a chunk once so play() only has to pass a number. Returns the
+// sound for play(), or -1 when MIXER_SOUNDS are already registered.
+int Mixer::add_sound(Mix_Chunk *chunk, int priority, int maxInstances)
+{
+   if (soundCount == MIXER_SOUNDS)
+   {
+      return -1;
+   }
+   Sound &sound = sounds[soundCount];
+   sound.samples = (const Sint16*)chunk->abuf;
+   sound.frames = chunk->alen / 4;
+   sound.priority = priority < 0 ? 0 : (priority >= MIXER_PRIORITIES ? MIXER_PRIORITIES - 1 : priority);
+   sound.maxInstances = maxInstances < 1 ? 1 : maxInstances;
+   return soundCount++;
+}
+
+// Returns a handle for stop() and set_volume(), or -1 if the queue is full
+// or sound didn't come from add_sound().
+int Mixer::play(int sound, int volume)
+{
+   if ((sound < 0) || (sound >= soundCount))
+   {
+      return -1;
+   }
+
+   Command command;
+   command.type = MIXER_PLAY;
+   command.handle = nextHandle;
+   command.sound = sound;
+   command.samples = sounds[sound].samples;
+   command.frames = sounds[sound].frames;
+   command.volume = volume < 0 ? 0 : (volume > MIX_MAX_VOLUME ? MIX_MAX_VOLUME : volume);
+   command.priority = sounds[sound].priority;
+   command.maxInstances = sounds[sound].maxInstances;
+   if (commands.push(command) == false)
+   {
+      drops++;
+      return -1;
+   }
+   // 0 marks a free voice, so it is never a handle
+   nextHandle = nextHandle == 0x7FFFFFFF ? 1 : nextHandle + 1;
+   return command.handle;
+}
+
+bool Mixer::stop(int handle)
+{
+   Command command;
+   command.type = MIXER_STOP;
+   command.handle = handle;
+   return commands.push(command);
+}
+
+bool Mixer::set_volume(int handle, int volume)
+{
+   Command command;
+   command.type = MIXER_VOLUME;
+   command.handle = handle;
+   command.volume = volume < 0 ? 0 : (volume > MIX_MAX_VOLUME ? MIX_MAX_VOLUME : volume);
+   return commands.push(command);
+}
+
+// adds the voice at the new end of the list
+void Mixer::link(List &list, Link Voice::*member, int index)
+{
+   Link &node = voices[index].*member;
+   node.previous = list.last;
+   node.next = -1;
+   if (list.last == -1)
+   {
+      list.first = index;
+   }
+   else
+   {
+      (voices[list.last].*member).next = index;
+   }
+   list.last = index;
+}
+
+void Mixer::unlink(List &list, Link Voice::*member, int index)
+{
+   Link &node = voices[index].*member;
+   if (node.previous == -1)
+   {
+      list.first = node.next;
+   }
+   else
+   {
+      (voices[node.previous].*member).next = node.next;
+   }
+   if (node.next == -1)
+   {
+      list.last = node.previous;
+   }
+   else
+   {
+      (voices[node.next].*member).previous = node.previous;
+   }
+}
+
+int Mixer::loudness(int volume)
+{
+   return volume * (MIXER_LOUDNESS - 1) / MIX_MAX_VOLUME;
+}
+
+// The voice a sound of this priority may take over, or -1 if every one
+// playing is more important. Looks at no more than the heads of the lists.
+int Mixer::choose_victim(int priority)
+{
+   for (int p = 0; p <= priority; p++)
+   {
+      if (policy == MIXER_STEAL_OLDEST)
+      {
+         if (byAge[p].first != -1)
+         {
+            return byAge[p].first;
+         }
+      }
+      else
+      {
+         for (int l = 0; l < MIXER_LOUDNESS; l++)
+         {
+            if (byLoudness[p][l].first != -1)
+            {
+               return byLoudness[p][l].first;
+            }
+         }
+      }
+   }
+   return -1;
+}
+
+void Mixer::start(const Command &command)
+{
+   if (command.frames <= 0)
+   {
+      return;
+   }
+
+   if (instanceCount[command.sound] >= command.maxInstances)
+   {
+      release(instances[command.sound].first);
+      steals++;
+   }
+   else if (freeCount == 0)
+   {
+      int victim = choose_victim(command.priority);
+      if (victim == -1)
+      {
+         drops++;
+         return;
+      }
+      release(victim);
+      steals++;
+   }
+
+   int index = freeVoices[--freeCount];
+   Voice &voice = voices[index];
+   voice.handle = command.handle;
+   voice.sound = command.sound;
+   voice.samples = command.samples;
+   voice.frames = command.frames;
+   voice.position = 0;
+   voice.volume = command.volume;
+   voice.priority = command.priority;
+   voice.slot = playing;
+   active[playing++] = index;
+   link(byAge[voice.priority], &Voice::age, index);
+   link(byLoudness[voice.priority][loudness(voice.volume)], &Voice::loud, index);
+   link(instances[voice.sound], &Voice::same, index);
+   instanceCount[voice.sound]++;
+   handleVoices[voice.handle & (MIXER_HANDLES - 1)] = index;
+}
+
+void Mixer::release(int index)
+{
+   Voice &voice = voices[index];
+   unlink(byAge[voice.priority], &Voice::age, index);
+   unlink(byLoudness[voice.priority][loudness(voice.volume)], &Voice::loud, index);
+   unlink(instances[voice.sound], &Voice::same, index);
+   instanceCount[voice.sound]--;
+
+   // the last active voice fills the gap
+   int last = active[--playing];
+   active[voice.slot] = last;
+   voices[last].slot = voice.slot;
+
+   voice.handle = 0;
+   freeVoices[freeCount++] = index;
+}
+
+// -1 once the voice finished or was taken over
+int Mixer::find(int handle)
+{
+   int index = handleVoices[handle & (MIXER_HANDLES - 1)];
+   if ((index == -1) || (voices[index].handle != handle))
+   {
+      return -1;
+   }
+   return index;
+}
+
+void Mixer::apply(const Command &command)
+{
+   if (command.type == MIXER_PLAY)
+   {
+      start(command);
+      return;
+   }
+
+   int index = find(command.handle);
+   if (index == -1)
+   {
+      return;
+   }
+   if (command.type == MIXER_STOP)
+   {
+      release(index);
+   }
+   else
+   {
+      Voice &voice = voices[index];
+      unlink(byLoudness[voice.priority][loudness(voice.volume)], &Voice::loud, index);
+      voice.volume = command.volume;
+      link(byLoudness[voice.priority][loudness(voice.volume)], &Voice::loud, index);
+   }
+}
+
+void Mixer::mix(Sint16 *stream, int frames)
+{
+   Command command;
+   while (commands.pop(command) == true)
+   {
+      apply(command);
+   }
+
+   // a finished voice is swapped for the last one, which still has to be mixed
+   for (int i = 0; i < playing; )
+   {
+      Voice &voice = voices[active[i]];
+      int left = voice.frames - voice.position;
+      int count = left < frames ? left : frames;
+      if (voice.volume > 0)
+      {
+         mix_voice(stream, voice.samples + voice.position * 2, count, voice.volume);
+      }
+      voice.position += count;
+      if (voice.position == voice.frames)
+      {
+         release(active[i]);
+      }
+      else
+      {
+         i++;
+      }
+   }
+}
+
+// audio thread only
+int Mixer::get_playing()
+{
+   return playing;
+}
+
+int Mixer::get_steals()
+{
+   return steals;
+}
+
+// sounds that never got a voice, including those the full queue turned away
+int Mixer::get_drops()
+{
+   return drops;
+}
+
+// Call once a frame. Returns true when a second has gone by and the per
+// second numbers are new.
+bool Mixer::update_rates(Uint32 ticks)
+{
+   if (ticks - rateStart < 1000)
+   {
+      return false;
+   }
+   int totalSteals = steals;
+   int totalDrops = drops;
+   stealsPerSecond = (totalSteals - rateSteals) * 1000 / (int)(ticks - rateStart);
+   dropsPerSecond = (totalDrops - rateDrops) * 1000 / (int)(ticks - rateStart);
+   rateSteals = totalSteals;
+   rateDrops = totalDrops;
+   rateStart = ticks;
+   return true;
+}
+
+int Mixer::get_steals_per_second()
+{
+   return stealsPerSecond;
+}
+
+int Mixer::get_drops_per_second()
+{
+   return dropsPerSecond;
+}
+
+void Mixer::report()
+{
+   std::cout << "mixer: " << poolSize << " voices, " << steals << " steals, " << drops << " drops\n";
+}
+
+void Mixer::mix_callback(void *data, Sint16 *stream, int frames)
+{
+   ((Mixer*)data)->mix(stream, frames);
+}
+
+// Mixes as usual and then as many voices again as the pool holds, at volume
+// 0 so nothing is heard, which makes the callback as slow as it is with
+// every voice playing. For AudioDevice::set_probe_load.
+void Mixer::load_callback(void *data, Sint16 *stream, int frames)
+{
+   Mixer *mixer = (Mixer*)data;
+   mixer->mix(stream, frames);
+   for (int i = 0; i < mixer->poolSize; i++)
+   {
+      mix_voice(stream, stream, frames, 0);
+   }
+}
+
+#endif
@@ -2,7 +2,19 @@
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
 #include "SDL/SDL_mixer.h"
+#include "pak_file.h"
+#include "audio_device.h"
+#include "audio_mixer.h"
+#include "music_stream.h"
 #include <string>
+#include <sstream>
+#include <map>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -14,12 +26,19 @@ TTF_Font *font = NULL;
 SDL_Event event;
 SDL_Color textColor = {0, 0, 0};
 
-Mix_Music *music = NULL;
+MusicStream music;
 Mix_Chunk *scratch = NULL;
 Mix_Chunk *high = NULL;
 Mix_Chunk *med = NULL;
 Mix_Chunk *low = NULL;
 
+AudioDevice audio;
+// twice SDL_mixer's default channels; a burst of key presses steals rather than drops
+Mixer mixer(16, MIXER_STEAL_OLDEST);
+int scratchSound = -1, highSound = -1, medSound = -1, lowSound = -1;
+// kept alive for SDL_putenv
+std::string audioDriver;
+
 void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
 {
    SDL_Rect offset;
@@ -28,11 +47,24 @@ void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination,
    SDL_BlitSurface(source, clip, destination, &offset);
 }
 
-SDL_Surface *load_image(std::string filename)
+// made with "pak lesson11.pak background.png lazy.ttf *.wav"
+PakFile pak;
+
+// from the pak when it has the file, otherwise straight off the disk
+SDL_RWops *open_asset(std::string path)
+{
+   SDL_RWops *asset = pak.open_asset(path);
+   if (asset == NULL)
+   {
+      asset = SDL_RWFromFile(path.c_str(), "rb");
+   }
+   return asset;
+}
+
+// the part of load_image that has to run on the main thread, once the video mode is set
+SDL_Surface *optimize_image(SDL_Surface* loadedImage)
 {
-   SDL_Surface* loadedImage = NULL;
    SDL_Surface* optimizedImage = NULL;
-   loadedImage = IMG_Load(filename.c_str());
    if (loadedImage != NULL)
    {
       optimizedImage = SDL_DisplayFormat(loadedImage);
@@ -43,154 +75,822 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
-bool init()
+SDL_Surface *load_image(std::string filename)
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   return optimize_image(IMG_Load_RW(open_asset(filename), 1));
+}
+
+enum ResourceType
+{
+   RESOURCE_IMAGE,
+   RESOURCE_FONT,
+   RESOURCE_SOUND
+};
+
+struct ResourceKey
+{
+   ResourceType type;
+   std::string path;
+   // font point size, 0 for everything else
+   int variant;
+
+   bool operator<(const ResourceKey &other) const
    {
-      return false;
+      if (type != other.type)
+      {
+         return type < other.type;
+      }
+      if (path != other.path)
+      {
+         return path < other.path;
+      }
+      return variant < other.variant;
    }
+};
+
+struct Resource
+{
+   void *data;
+   int refs;
+   int bytes;
+   // when the last reference went away, so the oldest unused entry goes first
+   Uint32 released;
+};
+
+// Hands out one shared copy of each image, font and sound,
+// counting references. Entries nobody holds stay resident until the cache
+// goes over its byte budget, then the longest unused are freed first.
+class ResourceCache
+{
+   private:
+      std::map<ResourceKey, Resource> entries;
+      std::map<void*, ResourceKey> owners;
+      int budget;
+      int resident;
+      void *acquire(ResourceType type, std::string path, int variant);
+      void destroy(const ResourceKey &key, Resource &resource);
+      void trim();
+   public:
+      ResourceCache(int budgetBytes);
+      ~ResourceCache();
+      SDL_Surface *get_image(std::string path);
+      TTF_Font *get_font(std::string path, int size);
+      Mix_Chunk *get_sound(std::string path);
+      void *lookup(ResourceType type, std::string path, int variant);
+      void adopt(ResourceType type, std::string path, int variant, void *data);
+      void release(void *data);
+      void set_budget(int budgetBytes);
+      void report();
+};
+
+ResourceCache::ResourceCache(int budgetBytes)
+{
+   budget = budgetBytes;
+   resident = 0;
+}
 
-   if (TTF_Init() == -1)
+ResourceCache::~ResourceCache()
+{
+   for (std::map<ResourceKey, Resource>::iterator i = entries.begin(); i != entries.end(); i++)
    {
-      return false;
+      destroy(i->first, i->second);
    }
+}
 
-   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+// returns a new reference to an entry that is already loaded, or NULL
+void *ResourceCache::lookup(ResourceType type, std::string path, int variant)
+{
+   ResourceKey key;
+   key.type = type;
+   key.path = path;
+   key.variant = variant;
 
-   if (screen == NULL)
+   std::map<ResourceKey, Resource>::iterator found = entries.find(key);
+   if (found == entries.end())
    {
-      return false;
+      return NULL;
    }
+   found->second.refs++;
+   return found->second.data;
+}
 
-   SDL_WM_SetCaption("music", NULL);
+// takes ownership of something loaded elsewhere, with the caller holding the first reference
+void ResourceCache::adopt(ResourceType type, std::string path, int variant, void *data)
+{
+   if (data == NULL)
+   {
+      return;
+   }
+
+   ResourceKey key;
+   key.type = type;
+   key.path = path;
+   key.variant = variant;
+
+   Resource resource;
+   resource.data = data;
+   resource.refs = 1;
+   resource.bytes = 0;
+   resource.released = 0;
 
-   if (Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 4096) == -1)
+   if (type == RESOURCE_IMAGE)
    {
-      return false;
+      SDL_Surface *image = (SDL_Surface*)data;
+      resource.bytes = sizeof(SDL_Surface) + image->h * image->pitch;
+   }
+   else if (type == RESOURCE_SOUND)
+   {
+      resource.bytes = sizeof(Mix_Chunk) + ((Mix_Chunk*)data)->alen;
+   }
+   else
+   {
+      // FreeType keeps the file around, so its size is a fair estimate
+      struct stat info;
+      resource.bytes = (stat(path.c_str(), &info) == 0) ? info.st_size : 0;
    }
 
-   return true;
+   entries[key] = resource;
+   owners[data] = key;
+   resident += resource.bytes;
+   trim();
 }
 
-bool load_files()
+void *ResourceCache::acquire(ResourceType type, std::string path, int variant)
 {
-   background = load_image("background.png");
-   if (background == NULL)
+   void *data = lookup(type, path, variant);
+   if (data != NULL)
    {
-      return 1;
+      return data;
    }
 
-   font = TTF_OpenFont("lazy.ttf", 28);
-   if (font == NULL)
+   if (type == RESOURCE_IMAGE)
    {
-      return 1;
+      data = load_image(path);
+   }
+   else if (type == RESOURCE_FONT)
+   {
+      data = TTF_OpenFontRW(open_asset(path), 1, variant);
+   }
+   else if (type == RESOURCE_SOUND)
+   {
+      data = Mix_LoadWAV_RW(open_asset(path), 1);
+   }
+
+   adopt(type, path, variant, data);
+   return data;
+}
+
+void ResourceCache::destroy(const ResourceKey &key, Resource &resource)
+{
+   if (key.type == RESOURCE_IMAGE)
+   {
+      SDL_FreeSurface((SDL_Surface*)resource.data);
+   }
+   else if (key.type == RESOURCE_FONT)
+   {
+      TTF_CloseFont((TTF_Font*)resource.data);
+   }
+   else if (key.type == RESOURCE_SOUND)
+   {
+      Mix_FreeChunk((Mix_Chunk*)resource.data);
+   }
+   resident -= resource.bytes;
+}
+
+void ResourceCache::trim()
+{
+   while (resident > budget)
+   {
+      std::map<ResourceKey, Resource>::iterator oldest = entries.end();
+      for (std::map<ResourceKey, Resource>::iterator i = entries.begin(); i != entries.end(); i++)
+      {
+         if ((i->second.refs == 0) && ((oldest == entries.end()) || (i->second.released < oldest->second.released)))
+         {
+            oldest = i;
+         }
+      }
+
+      // everything left is in use, the budget will have to wait
+      if (oldest == entries.end())
+      {
+         return;
+      }
+
+      owners.erase(oldest->second.data);
+      destroy(oldest->first, oldest->second);
+      entries.erase(oldest);
+   }
+}
+
+SDL_Surface *ResourceCache::get_image(std::string path)
+{
+   return (SDL_Surface*)acquire(RESOURCE_IMAGE, path, 0);
+}
+
+TTF_Font *ResourceCache::get_font(std::string path, int size)
+{
+   return (TTF_Font*)acquire(RESOURCE_FONT, path, size);
+}
+
+Mix_Chunk *ResourceCache::get_sound(std::string path)
+{
+   return (Mix_Chunk*)acquire(RESOURCE_SOUND, path, 0);
+}
+
+void ResourceCache::release(void *data)
+{
+   std::map<void*, ResourceKey>::iterator owner = owners.find(data);
+   if (owner == owners.end())
+   {
+      return;
+   }
+
+   Resource &resource = entries[owner->second];
+   if (resource.refs > 0)
+   {
+      resource.refs--;
+   }
+   if (resource.refs == 0)
+   {
+      resource.released = SDL_GetTicks();
+      trim();
+   }
+}
+
+void ResourceCache::set_budget(int budgetBytes)
+{
+   budget = budgetBytes;
+   trim();
+}
+
+void ResourceCache::report()
+{
+   const char *names[] = { "image", "font", "sound" };
+   for (std::map<ResourceKey, Resource>::iterator i = entries.begin(); i != entries.end(); i++)
+   {
+      std::cout << names[i->first.type] << " " << i->first.path;
+      if (i->first.variant != 0)
+      {
+         std::cout << " (" << i->first.variant << ")";
+      }
+      std::cout << ": " << i->second.bytes << " bytes, " << i->second.refs << " refs\n";
+   }
+   std::cout << "resident: " << resident << " of " << budget << " bytes\n";
+}
+
+// 32 MB is plenty for everything this lesson loads
+ResourceCache cache(32 * 1024 * 1024);
+
+// One load handed to the worker pool. The worker fills in result; for
+// images that is the decoded surface, which the main thread then converts.
+struct LoadJob
+{
+   ResourceType type;
+   std::string path;
+   int variant;
+   // every pointer waiting on this file, so queueing it twice decodes it once
+   std::vector<void**> targets;
+   void *result;
+   bool done;
+   bool collected;
+};
+
+void free_loaded(ResourceType type, void *data)
+{
+   if (data == NULL)
+   {
+      return;
+   }
+   if (type == RESOURCE_IMAGE)
+   {
+      SDL_FreeSurface((SDL_Surface*)data);
+   }
+   else if (type == RESOURCE_FONT)
+   {
+      TTF_CloseFont((TTF_Font*)data);
+   }
+   else if (type == RESOURCE_SOUND)
+   {
+      Mix_FreeChunk((Mix_Chunk*)data);
+   }
+}
+
+// Collects how long each startup step took and when it started, from any
+// thread, so the report shows which steps overlapped and which one is the
+// critical path.
+class StartupProfiler
+{
+   private:
+      struct Step
+      {
+         std::string name;
+         double start, end;
+      };
+      std::chrono::steady_clock::time_point origin;
+      std::vector<Step> steps;
+      SDL_mutex *lock;
+      static bool earlier(const Step &a, const Step &b);
+   public:
+      StartupProfiler();
+      ~StartupProfiler();
+      double now();
+      void record(std::string name, double start);
+      void report();
+};
+
+StartupProfiler::StartupProfiler()
+{
+   origin = std::chrono::steady_clock::now();
+   lock = SDL_CreateMutex();
+}
+
+StartupProfiler::~StartupProfiler()
+{
+   SDL_DestroyMutex(lock);
+}
+
+// milliseconds since the program started
+double StartupProfiler::now()
+{
+   return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void StartupProfiler::record(std::string name, double start)
+{
+   Step step;
+   step.name = name;
+   step.start = start;
+   step.end = now();
+   SDL_mutexP(lock);
+   steps.push_back(step);
+   SDL_mutexV(lock);
+}
+
+bool StartupProfiler::earlier(const Step &a, const Step &b)
+{
+   return a.start < b.start;
+}
+
+void StartupProfiler::report()
+{
+   SDL_mutexP(lock);
+   std::vector<Step> sorted = steps;
+   SDL_mutexV(lock);
+   std::stable_sort(sorted.begin(), sorted.end(), earlier);
+
+   std::cout << "Startup, " << now() << " ms to interactive:" << std::endl;
+   for (size_t i = 0; i < sorted.size(); i++)
+   {
+      std::cout << "  at " << sorted[i].start << " ms " << sorted[i].name << " took " << (sorted[i].end - sorted[i].start) << " ms" << std::endl;
    }
+}
+
+StartupProfiler profiler;
+
+// Decodes on a pool of SDL threads. Everything that touches the display
+// (SDL_DisplayFormat) and the cache happens in poll() on the main thread,
+// which also assigns each finished load to the pointer it was queued with.
+class AsyncLoader
+{
+   private:
+      std::vector<LoadJob*> jobs;
+      std::vector<SDL_Thread*> workers;
+      size_t next;
+      size_t finished;
+      int failed;
+      bool quitting;
+      SDL_mutex *lock;
+      SDL_cond *wake;
+      // FreeType shares one library between fonts, so opens take turns
+      SDL_mutex *fontLock;
+      static int work(void *data);
+   public:
+      AsyncLoader(int threadCount);
+      ~AsyncLoader();
+      void load(ResourceType type, std::string path, int variant, void **target);
+      void poll();
+      bool is_done();
+      int get_failed();
+      float get_progress();
+};
+
+AsyncLoader::AsyncLoader(int threadCount)
+{
+   next = 0;
+   finished = 0;
+   failed = 0;
+   quitting = false;
+   lock = SDL_CreateMutex();
+   wake = SDL_CreateCond();
+   fontLock = SDL_CreateMutex();
+   for (int i = 0; i < (threadCount < 1 ? 1 : threadCount); i++)
+   {
+      workers.push_back(SDL_CreateThread(work, this));
+   }
+}
+
+AsyncLoader::~AsyncLoader()
+{
+   SDL_mutexP(lock);
+   quitting = true;
+   SDL_CondBroadcast(wake);
+   SDL_mutexV(lock);
+
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      SDL_WaitThread(workers[i], NULL);
+   }
+
+   // anything decoded but never picked up by poll()
+   for (size_t i = 0; i < jobs.size(); i++)
+   {
+      if (jobs[i]->collected == false)
+      {
+         free_loaded(jobs[i]->type, jobs[i]->result);
+      }
+      delete jobs[i];
+   }
+
+   SDL_DestroyMutex(fontLock);
+   SDL_DestroyCond(wake);
+   SDL_DestroyMutex(lock);
+}
+
+int AsyncLoader::work(void *data)
+{
+   AsyncLoader *loader = (AsyncLoader*)data;
+   while (true)
+   {
+      SDL_mutexP(loader->lock);
+      while ((loader->quitting == false) && (loader->next >= loader->jobs.size()))
+      {
+         SDL_CondWait(loader->wake, loader->lock);
+      }
+      if (loader->quitting == true)
+      {
+         SDL_mutexV(loader->lock);
+         return 0;
+      }
+      LoadJob *job = loader->jobs[loader->next++];
+      SDL_mutexV(loader->lock);
+
+      double start = profiler.now();
+      void *result = NULL;
+      if (job->type == RESOURCE_IMAGE)
+      {
+         result = IMG_Load_RW(open_asset(job->path), 1);
+      }
+      else if (job->type == RESOURCE_FONT)
+      {
+         SDL_mutexP(loader->fontLock);
+         result = TTF_OpenFontRW(open_asset(job->path), 1, job->variant);
+         SDL_mutexV(loader->fontLock);
+      }
+      else if (job->type == RESOURCE_SOUND)
+      {
+         result = Mix_LoadWAV_RW(open_asset(job->path), 1);
+      }
+      profiler.record("load " + job->path, start);
+
+      SDL_mutexP(loader->lock);
+      job->result = result;
+      job->done = true;
+      SDL_mutexV(loader->lock);
+   }
+}
+
+void AsyncLoader::load(ResourceType type, std::string path, int variant, void **target)
+{
+   // already resident, nothing to decode
+   void *cached = cache.lookup(type, path, variant);
+   if (cached != NULL)
+   {
+      *target = cached;
+      return;
+   }
+
+   SDL_mutexP(lock);
+   for (size_t i = 0; i < jobs.size(); i++)
+   {
+      if ((jobs[i]->collected == false) && (jobs[i]->type == type) && (jobs[i]->path == path) && (jobs[i]->variant == variant))
+      {
+         jobs[i]->targets.push_back(target);
+         SDL_mutexV(lock);
+         return;
+      }
+   }
+
+   LoadJob *job = new LoadJob;
+   job->type = type;
+   job->path = path;
+   job->variant = variant;
+   job->targets.push_back(target);
+   job->result = NULL;
+   job->done = false;
+   job->collected = false;
+
+   jobs.push_back(job);
+   SDL_CondSignal(wake);
+   SDL_mutexV(lock);
+}
 
-   music = Mix_LoadMUS("beat.wav");
-   if (music == NULL)
+void AsyncLoader::poll()
+{
+   SDL_mutexP(lock);
+   for (size_t i = 0; i < jobs.size(); i++)
+   {
+      LoadJob *job = jobs[i];
+      if ((job->done == false) || (job->collected == true))
+      {
+         continue;
+      }
+
+      void *result = job->result;
+      if (job->type == RESOURCE_IMAGE)
+      {
+         double start = profiler.now();
+         result = optimize_image((SDL_Surface*)result);
+         profiler.record("convert " + job->path, start);
+      }
+
+      // the cache takes the first reference, every other waiter gets its own
+      cache.adopt(job->type, job->path, job->variant, result);
+      *job->targets[0] = result;
+      for (size_t t = 1; t < job->targets.size(); t++)
+      {
+         *job->targets[t] = cache.lookup(job->type, job->path, job->variant);
+      }
+
+      job->collected = true;
+      finished++;
+      if (result == NULL)
+      {
+         failed++;
+      }
+   }
+   SDL_mutexV(lock);
+}
+
+bool AsyncLoader::is_done()
+{
+   return finished == jobs.size();
+}
+
+int AsyncLoader::get_failed()
+{
+   return failed;
+}
+
+float AsyncLoader::get_progress()
+{
+   if (jobs.empty() == true)
+   {
+      return 1.f;
+   }
+   return (float)finished / jobs.size();
+}
+
+// TTF and the mixer don't need the window, so they come up on their own
+// threads while the main thread opens it. Each stores its result in the int
+// it is handed.
+int init_fonts(void *data)
+{
+   double start = profiler.now();
+   *(int*)data = TTF_Init();
+   profiler.record("TTF_Init", start);
+   return 0;
+}
+
+int init_audio(void *data)
+{
+   double start = profiler.now();
+   // probed with the callback that will run, loaded as if every voice played
+   audio.set_source(Mixer::mix_callback, &mixer);
+   audio.set_probe_load(Mixer::load_callback, &mixer);
+   *(int*)data = audio.open() ? 0 : -1;
+   music.attach(audio.get_frequency());
+   profiler.record("open audio", start);
+   return 0;
+}
+
+bool init()
+{
+   // only what this lesson uses, no joystick, CD-ROM or timer probing
+   double start = profiler.now();
+   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) == -1)
    {
       return false;
    }
+   profiler.record("SDL_Init", start);
+
+   int fontsResult = -1, audioResult = -1;
+   SDL_Thread *fonts = SDL_CreateThread(init_fonts, &fontsResult);
+   if (fonts == NULL)
+   {
+      init_fonts(&fontsResult);
+   }
+   SDL_Thread *audio = SDL_CreateThread(init_audio, &audioResult);
+   if (audio == NULL)
+   {
+      init_audio(&audioResult);
+   }
 
-   scratch = Mix_LoadWAV("scratch.wav");
-   high = Mix_LoadWAV("high.wav");
-   med = Mix_LoadWAV("medium.wav");
-   low = Mix_LoadWAV("low.wav");
+   start = profiler.now();
+   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+   profiler.record("SDL_SetVideoMode", start);
 
-   if ((scratch == NULL) || (high == NULL) || (med == NULL) || (low == NULL))
+   if (fonts != NULL)
+   {
+      SDL_WaitThread(fonts, NULL);
+   }
+   if (audio != NULL)
+   {
+      SDL_WaitThread(audio, NULL);
+   }
+
+   if ((screen == NULL) || (fontsResult == -1) || (audioResult == -1))
    {
       return false;
    }
 
+   SDL_WM_SetCaption("music", NULL);
+
    return true;
 }
 
+AsyncLoader *loader = NULL;
+
+// only queues the loads, the main loop picks them up as they finish
+void load_files()
+{
+   // a missing pak just means loose files
+   pak.open("lesson11.pak");
+
+   // streamed, so this only reads the header however long the track is
+   size_t beatSize = 0;
+   const void *beat = pak.map_asset("beat.wav", &beatSize);
+   if (beat != NULL)
+   {
+      music.open_mapped(beat, beatSize);
+   }
+   else
+   {
+      music.open("beat.wav");
+   }
+
+   loader = new AsyncLoader(std::thread::hardware_concurrency());
+
+   loader->load(RESOURCE_IMAGE, "background.png", 0, (void**)&background);
+   loader->load(RESOURCE_FONT, "lazy.ttf", 28, (void**)&font);
+   loader->load(RESOURCE_SOUND, "scratch.wav", 0, (void**)&scratch);
+   loader->load(RESOURCE_SOUND, "high.wav", 0, (void**)&high);
+   loader->load(RESOURCE_SOUND, "medium.wav", 0, (void**)&med);
+   loader->load(RESOURCE_SOUND, "low.wav", 0, (void**)&low);
+}
+
+void show_progress(float progress)
+{
+   SDL_Rect bar = { SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 10, SCREEN_WIDTH / 2, 20 };
+   SDL_FillRect(screen, &screen->clip_rect, SDL_MapRGB(screen->format, 0x00, 0x00, 0x00));
+   SDL_FillRect(screen, &bar, SDL_MapRGB(screen->format, 0x40, 0x40, 0x40));
+   bar.w = (Uint16)(bar.w * progress);
+   SDL_FillRect(screen, &bar, SDL_MapRGB(screen->format, 0xFF, 0xFF, 0xFF));
+}
+
 void clean_up()
 {
-   SDL_FreeSurface(background);
+   delete loader;
+
+   music.report();
+   music.detach();
+   // the mixer may still be reading the sounds about to be freed
+   audio.set_source(NULL, NULL);
+   cache.release(background);
+   cache.release(scratch);
+   cache.release(high);
+   cache.release(med);
+   cache.release(low);
+   cache.release(font);
+   // nothing is held any more, so this empties the cache while audio and TTF are still up
+   cache.set_budget(0);
+   // fonts and the music read from the mapping until they are closed, so it goes last
+   music.close();
+   pak.close();
 
-   Mix_FreeChunk(scratch);
-   Mix_FreeChunk(high);
-   Mix_FreeChunk(med);
-   Mix_FreeChunk(low);
-   Mix_FreeMusic(music);
-   TTF_CloseFont(font);
-   Mix_CloseAudio();
+   mixer.report();
+   audio.report();
+   audio.close();
    
    TTF_Quit();
    SDL_Quit();
 }
 
-void play_sound(Mix_Chunk *sound)
+// the scratch outranks the beeps and each sound keeps at most 4 voices
+void add_sounds()
+{
+   scratchSound = mixer.add_sound(scratch, 1, 4);
+   highSound = mixer.add_sound(high, 0, 4);
+   medSound = mixer.add_sound(med, 0, 4);
+   lowSound = mixer.add_sound(low, 0, 4);
+}
+
+void play_sound(int sound)
 {
-   Mix_PlayChannel(-1, sound, 0);
+   audio.trigger();
+   mixer.play(sound);
 }
 
 int main(int argc, char* args[])
 {
    bool quit = false;
 
-   if (init() == false)
+   // --audio-driver dummy (or disk) runs without a sound card
+   for (int i = 1; i + 1 < argc; i++)
    {
-      return 1;
-   }
-   
-   if (load_files() == false)
-   {
-      return 1;
+      if (std::string(args[i]) == "--audio-driver")
+      {
+         audioDriver = std::string("SDL_AUDIODRIVER=") + args[i + 1];
+         SDL_putenv((char*)audioDriver.c_str());
+      }
    }
 
-   apply_surface(0, 0, background, screen);
-     
-   if (SDL_Flip(screen) == -1)
+   if (init() == false)
    {
       return 1;
    }
+   
+   load_files();
+   bool loading = true;
+
    while(quit == false)
    {
+      if (loading == true)
+      {
+         loader->poll();
+         show_progress(loader->get_progress());
+
+         if (loader->is_done() == true)
+         {
+            loading = false;
+            if (loader->get_failed() > 0)
+            {
+               return 1;
+            }
+            cache.report();
+            profiler.report();
+            add_sounds();
+            apply_surface(0, 0, background, screen);
+         }
+
+         if (SDL_Flip(screen) == -1)
+         {
+            return 1;
+         }
+      }
+
       while (SDL_PollEvent(&event))
       {
-         if (event.type == SDL_KEYDOWN)
+         if ((loading == false) && (event.type == SDL_KEYDOWN))
          {
             SDLKey k = event.key.keysym.sym;
 
             if (k == SDLK_1)
             {
-               play_sound(scratch);
+               play_sound(scratchSound);
             }
             else if (k == SDLK_2)
             {
-               play_sound(high);
+               play_sound(highSound);
             }
             else if (k == SDLK_3)
             {
-               play_sound(med);
+               play_sound(medSound);
             }
             else if(k == SDLK_4)
             {
-               play_sound(low);
+               play_sound(lowSound);
             }
             else if (k == SDLK_9)
             {
-               if (Mix_PlayingMusic() == 0)
+               if (music.is_playing() == false)
                {
-                  Mix_PlayMusic(music, -1);
+                  music.play(true);
                }
                else
                {
-                  if (Mix_PausedMusic() == 1)
+                  if (music.is_paused() == true)
                   {
-                     Mix_ResumeMusic();
+                     music.resume();
                   }
                   else
                   {
-                     Mix_PauseMusic();
+                     music.pause();
                   }
                }
             }
             else if (k == SDLK_0)
             {
-               Mix_HaltMusic();
+               music.halt();
             }
          }
 
@@ -200,7 +900,13 @@ int main(int argc, char* args[])
          }
       }
 
-
+      // how hard the voice pool is pushed, to size it by
+      if ((loading == false) && (mixer.update_rates(SDL_GetTicks()) == true))
+      {
+         std::stringstream caption;
+         caption << "music - " << mixer.get_steals_per_second() << " steals/s, " << mixer.get_drops_per_second() << " drops/s";
+         SDL_WM_SetCaption(caption.str().c_str(), NULL);
+      }
    }
    clean_up();
 
@@ -0,0 +1,198 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_mixer.h"
+#include "audio_mixer.h"
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using std::cout;
+
+const int FREQUENCY = 44100;
+// a 1024 frame buffer is about 23 ms at 44.1 kHz
+const int BLOCK_FRAMES = 1024;
+const int BLOCKS = 40;
+const int ROUNDS = 5;
+// long enough that no voice runs out during a round
+const int SOUND_FRAMES = BLOCK_FRAMES * BLOCKS + 1;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+   return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void fill_noise(std::vector<Sint16> &samples, int amplitude)
+{
+   for (size_t i = 0; i < samples.size(); i++)
+   {
+      samples[i] = (Sint16)(rand() % (2 * amplitude + 1) - amplitude);
+   }
+}
+
+// a vector path has to give exactly what the scalar one does
+bool check_volumes(MixVoice path, const char *name)
+{
+   const int volumes[] = { 0, 1, 37, 64, 100, 127, MIX_MAX_VOLUME };
+   // odd so the scalar tail after the vector loop is covered too
+   const int frames = 1021;
+   std::vector<Sint16> source(frames * 2), expected(frames * 2), actual(frames * 2);
+   bool same = true;
+   for (size_t v = 0; v < sizeof(volumes) / sizeof(volumes[0]); v++)
+   {
+      // full range, so both clipping directions come up
+      fill_noise(source, 32767);
+      fill_noise(expected, 32767);
+      actual = expected;
+      mix_voice_scalar(&expected[0], &source[0], frames, volumes[v]);
+      path(&actual[0], &source[0], frames, volumes[v]);
+      if (memcmp(&expected[0], &actual[0], expected.size() * sizeof(Sint16)) != 0)
+      {
+         cout << "   " << name << " at volume " << volumes[v] << " DIFFERS from the scalar mix\n";
+         same = false;
+      }
+   }
+   return same;
+}
+
+// Mixes BLOCKS buffers with the given number of voices, each at its own
+// volume, and gives the best round in ms. scalar skips the Mixer and adds
+// the same voices with mix_voice_scalar for comparison.
+double run(std::vector<Sint16> &sound, int voiceCount, bool scalar)
+{
+   Mix_Chunk chunk;
+   chunk.allocated = 0;
+   chunk.abuf = (Uint8*)&sound[0];
+   chunk.alen = sound.size() * sizeof(Sint16);
+   chunk.volume = MIX_MAX_VOLUME;
+
+   std::vector<Sint16> stream(BLOCK_FRAMES * 2);
+   double best = 0;
+   for (int round = 0; round < ROUNDS; round++)
+   {
+      Mixer mixer;
+      int voice = mixer.add_sound(&chunk);
+      for (int i = 0; i < voiceCount; i++)
+      {
+         mixer.play(voice, 16 + i % (MIX_MAX_VOLUME - 16));
+      }
+      // the commands go across before the clock starts
+      mixer.mix(&stream[0], 0);
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for (int block = 0; block < BLOCKS; block++)
+      {
+         memset(&stream[0], 0, stream.size() * sizeof(Sint16));
+         if (scalar == true)
+         {
+            for (int i = 0; i < voiceCount; i++)
+            {
+               mix_voice_scalar(&stream[0], &sound[block * BLOCK_FRAMES * 2], BLOCK_FRAMES, 16 + i % (MIX_MAX_VOLUME - 16));
+            }
+         }
+         else
+         {
+            mixer.mix(&stream[0], BLOCK_FRAMES);
+         }
+      }
+      double ms = elapsed_ms(start);
+      if ((round == 0) || (ms < best))
+      {
+         best = ms;
+      }
+
+      if ((scalar == false) && (mixer.get_playing() != voiceCount))
+      {
+         cout << "   only " << mixer.get_playing() << " of " << voiceCount << " voices playing\n";
+      }
+   }
+   return best;
+}
+
+// Starts sounds into a small pool that is always full, so nearly every one
+// has to steal, and gives ns per trigger on the audio side.
+void run_triggers(std::vector<Sint16> &sound, StealPolicy policy, const char *name)
+{
+   const int pool = 32;
+   const int triggers = 1000000;
+   // as many as the queue holds between two callbacks
+   const int burst = MIXER_COMMANDS;
+
+   Mix_Chunk chunk;
+   chunk.allocated = 0;
+   chunk.abuf = (Uint8*)&sound[0];
+   chunk.alen = sound.size() * sizeof(Sint16);
+   chunk.volume = MIX_MAX_VOLUME;
+
+   Mixer mixer(pool, policy);
+   int sounds[8];
+   for (int i = 0; i < 8; i++)
+   {
+      // priorities 0 to 3, half of them held to 4 instances
+      sounds[i] = mixer.add_sound(&chunk, i % 4, i < 4 ? 4 : MIXER_VOICES);
+   }
+
+   double ms = 0;
+   for (int done = 0; done < triggers; done += burst)
+   {
+      for (int i = 0; i < burst; i++)
+      {
+         mixer.play(sounds[(done + i) % 8], 1 + (done + i) * 7 % MIX_MAX_VOLUME);
+      }
+      // no frames, so this is only the commands
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      mixer.mix(NULL, 0);
+      ms += elapsed_ms(start);
+   }
+
+   cout << name << ": " << ms * 1000000 / triggers << " ns per trigger, " << mixer.get_steals() << " steals, "
+        << mixer.get_drops() << " drops, " << mixer.get_playing() << " of " << pool << " voices playing\n";
+}
+
+// usage: mix_bench
+// Checks the vector mix against the scalar one, then times the Mixer with
+// 8, 64 and 512 voices playing at once and the cost of starting a sound
+// when the pool is full.
+int main(int argc, char* args[])
+{
+   const char *name = "scalar code only";
+   bool same = true;
+#ifdef AUDIO_MIXER_X86
+   if (mix_voice == mix_voice_avx2)
+   {
+      name = "AVX2";
+      same = check_volumes(mix_voice_avx2, "AVX2");
+   }
+   else if (mix_voice == mix_voice_sse2)
+   {
+      name = "SSE2";
+   }
+   // AVX2 hands its last few frames to SSE2, so that is checked either way
+   if (mix_voice != mix_voice_scalar)
+   {
+      same = check_volumes(mix_voice_sse2, "SSE2") && same;
+   }
+#endif
+   cout << "mixing with " << name << "\n";
+   cout << "vector mix " << (same ? "matches" : "does not match") << " the scalar mix\n";
+
+   std::vector<Sint16> sound(SOUND_FRAMES * 2);
+   // quiet enough that 8 voices rarely clip, loud enough that 512 do
+   fill_noise(sound, 4000);
+
+   const int counts[] = { 8, 64, 512 };
+   double period = BLOCK_FRAMES * 1000.0 / FREQUENCY;
+   for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+   {
+      double mixed = run(sound, counts[c], false) / BLOCKS;
+      double scalar = run(sound, counts[c], true) / BLOCKS;
+      cout << counts[c] << " voices: " << mixed * 1000 << " us per " << BLOCK_FRAMES << " frame buffer, "
+           << mixed * 1000000 / counts[c] << " ns per voice (scalar " << scalar * 1000000 / counts[c] << "), "
+           << mixed * 100 / period << "% of the buffer's " << period << " ms\n";
+   }
+
+   run_triggers(sound, MIXER_STEAL_OLDEST, "stealing the oldest");
+   run_triggers(sound, MIXER_STEAL_QUIETEST, "stealing the quietest");
+
+   return same ? 0 : 1;
+}
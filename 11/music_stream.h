@@ -0,0 +1,420 @@
+#ifndef MUSIC_STREAM_H
+#define MUSIC_STREAM_H
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_mixer.h"
+#include <string>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// how far ahead of the play position the kernel is asked to read, and how
+// far behind it pages are let go
+const size_t MUSIC_READ_AHEAD = 64 * 1024;
+
+// Plays a PCM WAV straight out of a mapping instead of decoding it into
+// memory first, so starting a track only reads its header. The audio
+// callback pulls samples from the mapped pages, asks for the next stretch
+// with MADV_WILLNEED as it goes and drops what it has played with
+// MADV_DONTNEED, which keeps the resident part of even a long track to
+// about two read-ahead windows. 8 and 16 bit, mono and stereo at any rate
+// are turned into the device's 16 bit stereo on the way out.
+//
+// play(), pause(), resume() and halt() are for the game thread and only
+// flip atomics; everything else in the stream belongs to the callback once
+// attach() has hooked it into SDL_mixer.
+class MusicStream
+{
+   private:
+      enum State { MUSIC_STOPPED, MUSIC_PLAYING, MUSIC_PAUSED };
+      void *mapping;
+      size_t mappingSize;
+      const Uint8 *samples;
+      size_t bytes;
+      int channels;
+      int bits;
+      int rate;
+      int frames;
+      int outputRate;
+      // source position in frames, 16.16 fixed point
+      Uint64 position;
+      Uint64 step;
+      size_t adviseAt;
+      size_t droppedTo;
+      std::atomic<int> state;
+      std::atomic<bool> rewind;
+      std::atomic<bool> looping;
+      bool parse(const Uint8 *file, size_t size);
+      bool use(const Uint8 *file, size_t size);
+      int sample(int frame, int channel);
+      void advise(size_t offset);
+      void fill(Sint16 *stream, int count);
+      static void hook(void *data, Uint8 *stream, int len);
+   public:
+      MusicStream();
+      ~MusicStream();
+      bool open(std::string filename);
+      bool open_mapped(const void *file, size_t size);
+      void close();
+      bool is_open();
+      void attach(int frequency);
+      void detach();
+      void set_frequency(int frequency);
+      void render(Sint16 *stream, int frames);
+      void play(bool loop);
+      void pause();
+      void resume();
+      void halt();
+      bool is_playing();
+      bool is_paused();
+      void report();
+};
+
+MusicStream::MusicStream()
+{
+   mapping = NULL;
+   mappingSize = 0;
+   samples = NULL;
+   bytes = 0;
+   channels = 0;
+   bits = 0;
+   rate = 0;
+   frames = 0;
+   outputRate = 0;
+   position = 0;
+   step = 0;
+   adviseAt = 0;
+   droppedTo = 0;
+   state = MUSIC_STOPPED;
+   rewind = false;
+   looping = false;
+}
+
+MusicStream::~MusicStream()
+{
+   close();
+}
+
+// finds the fmt and data chunks, only plain PCM is taken
+bool MusicStream::parse(const Uint8 *file, size_t size)
+{
+   if ((size < 12) || (memcmp(file, "RIFF", 4) != 0) || (memcmp(file + 8, "WAVE", 4) != 0))
+   {
+      return false;
+   }
+
+   bool format = false;
+   size_t at = 12;
+   while (at + 8 <= size)
+   {
+      const Uint8 *chunk = file + at;
+      size_t length = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((size_t)chunk[7] << 24);
+      if ((memcmp(chunk, "fmt ", 4) == 0) && (length >= 16) && (at + 8 + length <= size))
+      {
+         int tag = chunk[8] | (chunk[9] << 8);
+         channels = chunk[10] | (chunk[11] << 8);
+         rate = chunk[12] | (chunk[13] << 8) | (chunk[14] << 16) | (chunk[15] << 24);
+         bits = chunk[22] | (chunk[23] << 8);
+         format = (tag == 1) && ((channels == 1) || (channels == 2)) && ((bits == 8) || (bits == 16)) && (rate > 0);
+      }
+      else if ((memcmp(chunk, "data", 4) == 0) && (format == true))
+      {
+         // a truncated file still plays as far as it goes
+         samples = chunk + 8;
+         bytes = length < size - at - 8 ? length : size - at - 8;
+         frames = bytes / (channels * bits / 8);
+         return frames > 0;
+      }
+      // chunks are padded to an even length
+      at += 8 + length + (length & 1);
+   }
+   return false;
+}
+
+bool MusicStream::open(std::string filename)
+{
+   close();
+
+   int fd = ::open(filename.c_str(), O_RDONLY);
+   if (fd == -1)
+   {
+      return false;
+   }
+
+   struct stat info;
+   if ((fstat(fd, &info) == -1) || (info.st_size == 0))
+   {
+      ::close(fd);
+      return false;
+   }
+
+   void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if (mapped == MAP_FAILED)
+   {
+      return false;
+   }
+
+   if (use((const Uint8*)mapped, info.st_size) == false)
+   {
+      munmap(mapped, info.st_size);
+      return false;
+   }
+   mapping = mapped;
+   mappingSize = info.st_size;
+   return true;
+}
+
+// Plays from memory someone else mapped, like an entry in a pak, which has
+// to stay mapped until close().
+bool MusicStream::open_mapped(const void *file, size_t size)
+{
+   close();
+   return use((const Uint8*)file, size);
+}
+
+bool MusicStream::use(const Uint8 *file, size_t size)
+{
+   // the callback may be reading the old track
+   SDL_LockAudio();
+   bool found = parse(file, size);
+   if (found == false)
+   {
+      samples = NULL;
+   }
+   SDL_UnlockAudio();
+   if (found == false)
+   {
+      return false;
+   }
+
+   // the kernel reads further ahead and sooner forgets what is behind
+   size_t start = (size_t)samples & ~(size_t)(getpagesize() - 1);
+   madvise((void*)start, (size_t)samples + bytes - start, MADV_SEQUENTIAL);
+   return true;
+}
+
+void MusicStream::close()
+{
+   halt();
+   SDL_LockAudio();
+   samples = NULL;
+   bytes = 0;
+   frames = 0;
+   SDL_UnlockAudio();
+   if (mapping != NULL)
+   {
+      munmap(mapping, mappingSize);
+   }
+   mapping = NULL;
+   mappingSize = 0;
+}
+
+bool MusicStream::is_open()
+{
+   return samples != NULL;
+}
+
+// Becomes SDL_mixer's music at the device's frequency. The stream doesn't
+// have to be open yet, until it is the music is silence.
+void MusicStream::attach(int frequency)
+{
+   set_frequency(frequency);
+   Mix_HookMusic(hook, this);
+}
+
+// after this the callback no longer reads the mapping
+void MusicStream::detach()
+{
+   Mix_HookMusic(NULL, NULL);
+}
+
+// the rate render() writes at
+void MusicStream::set_frequency(int frequency)
+{
+   SDL_LockAudio();
+   outputRate = frequency;
+   SDL_UnlockAudio();
+}
+
+void MusicStream::play(bool loop)
+{
+   looping = loop;
+   rewind = true;
+   state = MUSIC_PLAYING;
+}
+
+void MusicStream::pause()
+{
+   int playing = MUSIC_PLAYING;
+   state.compare_exchange_strong(playing, MUSIC_PAUSED);
+}
+
+void MusicStream::resume()
+{
+   int paused = MUSIC_PAUSED;
+   state.compare_exchange_strong(paused, MUSIC_PLAYING);
+}
+
+void MusicStream::halt()
+{
+   state = MUSIC_STOPPED;
+}
+
+// true while paused as well, like Mix_PlayingMusic
+bool MusicStream::is_playing()
+{
+   return state != MUSIC_STOPPED;
+}
+
+bool MusicStream::is_paused()
+{
+   return state == MUSIC_PAUSED;
+}
+
+// one channel of one source frame as 16 bit
+int MusicStream::sample(int frame, int channel)
+{
+   if (channel >= channels)
+   {
+      channel = 0;
+   }
+   if (bits == 8)
+   {
+      return (samples[frame * channels + channel] - 128) * 256;
+   }
+   const Uint8 *at = samples + (frame * channels + channel) * 2;
+   return (Sint16)(at[0] | (at[1] << 8));
+}
+
+// called with the byte offset the callback is about to read from
+void MusicStream::advise(size_t offset)
+{
+   if (offset < adviseAt)
+   {
+      return;
+   }
+
+   size_t page = getpagesize();
+   size_t start = (size_t)samples;
+   size_t end = start + bytes;
+
+   size_t ahead = (start + offset) & ~(page - 1);
+   size_t aheadEnd = start + offset + MUSIC_READ_AHEAD < end ? start + offset + MUSIC_READ_AHEAD : end;
+   madvise((void*)ahead, aheadEnd - ahead, MADV_WILLNEED);
+
+   // whole pages that were played more than a window ago
+   if (offset > MUSIC_READ_AHEAD)
+   {
+      size_t from = (start + droppedTo + page - 1) & ~(page - 1);
+      size_t to = (start + offset - MUSIC_READ_AHEAD) & ~(page - 1);
+      if (to > from)
+      {
+         madvise((void*)from, to - from, MADV_DONTNEED);
+         droppedTo = to - start;
+      }
+   }
+
+   // half a window early, so the read is done before the callback gets there
+   adviseAt = offset + MUSIC_READ_AHEAD / 2;
+}
+
+// writes count frames of 16 bit stereo, silence once the track is over
+void MusicStream::fill(Sint16 *stream, int count)
+{
+   int frameBytes = channels * bits / 8;
+   int i = 0;
+   while (i < count)
+   {
+      int frame = (int)(position >> 16);
+      if (frame >= frames)
+      {
+         if (looping == false)
+         {
+            // unless the game restarted it in the meantime
+            int playing = MUSIC_PLAYING;
+            state.compare_exchange_strong(playing, MUSIC_STOPPED);
+            break;
+         }
+         position = 0;
+         frame = 0;
+         adviseAt = 0;
+         droppedTo = 0;
+      }
+      advise((size_t)frame * frameBytes);
+
+      // already in the device's format, nothing to do but copy
+      if ((step == 0x10000) && (channels == 2) && (bits == 16))
+      {
+         int run = frames - frame < count - i ? frames - frame : count - i;
+         memcpy(stream + i * 2, samples + (size_t)frame * 4, run * 4);
+         i += run;
+         position += (Uint64)run << 16;
+         continue;
+      }
+
+      // linear interpolation, holding the last frame at the very end
+      int next = frame + 1 < frames ? frame + 1 : (looping == true ? 0 : frame);
+      int fraction = (int)(position & 0xFFFF);
+      for (int channel = 0; channel < 2; channel++)
+      {
+         int a = sample(frame, channel);
+         int b = sample(next, channel);
+         // b - a can be 65535 and fraction 65535, past what an int holds
+         stream[i * 2 + channel] = (Sint16)(a + (int)(((Sint64)(b - a) * fraction) >> 16));
+      }
+      position += step;
+      i++;
+   }
+
+   if (i < count)
+   {
+      memset(stream + i * 2, 0, (count - i) * 4);
+   }
+}
+
+// Overwrites frames of 16 bit stereo with the music, or silence. The hook
+// calls this, and so can anything without a device.
+void MusicStream::render(Sint16 *stream, int frames)
+{
+   // play() sets rewind before state, so reading state first means a
+   // PLAYING seen here always comes with its rewind and never with one
+   // stale buffer of the old position
+   int current = state;
+   if (rewind.exchange(false) == true)
+   {
+      position = 0;
+      adviseAt = 0;
+      droppedTo = 0;
+   }
+   if ((samples == NULL) || (outputRate == 0) || (current != MUSIC_PLAYING))
+   {
+      memset(stream, 0, frames * 4);
+      return;
+   }
+
+   step = ((Uint64)rate << 16) / outputRate;
+   fill(stream, frames);
+}
+
+// SDL_mixer hands over the whole buffer and mixes its channels on top
+void MusicStream::hook(void *data, Uint8 *stream, int len)
+{
+   ((MusicStream*)data)->render((Sint16*)stream, len / 4);
+}
+
+void MusicStream::report()
+{
+   if (samples == NULL)
+   {
+      return;
+   }
+   std::cout << "music: " << frames << " frames at " << rate << " Hz, " << bits << " bit, " << channels << " channel(s), "
+             << bytes << " bytes streamed " << MUSIC_READ_AHEAD / 1024 << " KB ahead\n";
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include "SDL/SDL.h"
+#include "pak_file.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+using std::cout;
+
+// usage: pak assets.pak file [file ...]
+// Each file is stored under the path it was given as, which is the name
+// the lessons ask for.
+
+struct PakInput
+{
+   std::string name;
+   std::vector<char> contents;
+};
+
+bool by_name(const PakInput &A, const PakInput &B)
+{
+   return A.name < B.name;
+}
+
+bool read_file(std::string filename, std::vector<char> &contents)
+{
+   std::ifstream file(filename.c_str(), std::ios::binary);
+   if (file.is_open() == false)
+   {
+      return false;
+   }
+   contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+   return true;
+}
+
+int main(int argc, char* args[])
+{
+   if (argc < 3)
+   {
+      cout << "usage: " << args[0] << " output.pak file [file ...]\n";
+      return 1;
+   }
+
+   std::vector<PakInput> inputs(argc - 2);
+   for (int i = 2; i < argc; i++)
+   {
+      PakInput &input = inputs[i - 2];
+      input.name = args[i];
+      if (input.name.size() >= PAK_NAME_LENGTH)
+      {
+         cout << args[i] << ": name longer than " << PAK_NAME_LENGTH - 1 << " characters\n";
+         return 1;
+      }
+      if (read_file(args[i], input.contents) == false)
+      {
+         cout << args[i] << ": could not read\n";
+         return 1;
+      }
+   }
+
+   // the loader binary searches the index, which can only find one of two
+   // entries with the same name
+   std::sort(inputs.begin(), inputs.end(), by_name);
+   for (size_t i = 1; i < inputs.size(); i++)
+   {
+      if (inputs[i].name == inputs[i - 1].name)
+      {
+         cout << inputs[i].name << ": given more than once\n";
+         return 1;
+      }
+   }
+
+   PakHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, PAK_MAGIC, 4);
+   header.count = inputs.size();
+
+   std::vector<PakEntry> index(inputs.size());
+   Uint32 offset = sizeof(PakHeader) + inputs.size() * sizeof(PakEntry);
+   for (size_t i = 0; i < inputs.size(); i++)
+   {
+      offset = (offset + PAK_ALIGN - 1) / PAK_ALIGN * PAK_ALIGN;
+      memset(&index[i], 0, sizeof(PakEntry));
+      strncpy(index[i].name, inputs[i].name.c_str(), PAK_NAME_LENGTH - 1);
+      index[i].offset = offset;
+      index[i].size = inputs[i].contents.size();
+      offset += index[i].size;
+   }
+
+   std::ofstream pak(args[1], std::ios::binary);
+   if (pak.is_open() == false)
+   {
+      cout << args[1] << ": could not write\n";
+      return 1;
+   }
+
+   pak.write((const char*)&header, sizeof(header));
+   pak.write((const char*)&index[0], index.size() * sizeof(PakEntry));
+   for (size_t i = 0; i < inputs.size(); i++)
+   {
+      while (pak.tellp() < index[i].offset)
+      {
+         pak.put(0);
+      }
+      if (inputs[i].contents.empty() == false)
+      {
+         pak.write(&inputs[i].contents[0], inputs[i].contents.size());
+      }
+   }
+
+   // the last of it may only reach the disk here
+   pak.close();
+   if (pak.good() == false)
+   {
+      cout << args[1] << ": could not write\n";
+      return 1;
+   }
+
+   cout << inputs.size() << " files, " << offset << " bytes\n";
+   return 0;
+}
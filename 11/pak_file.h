@@ -0,0 +1,166 @@
+#ifndef PAK_FILE_H
+#define PAK_FILE_H
+
+#include "SDL/SDL.h"
+#include <string>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// A .pak is a PakHeader, then count PakEntry records sorted by name, then
+// the files themselves, each starting on a PAK_ALIGN boundary. The whole
+// thing is mapped once and every asset is handed to SDL as a read-only
+// memory RWops, so opening one costs a binary search and no syscalls.
+const char PAK_MAGIC[4] = { 'P', 'A', 'K', '1' };
+const int PAK_NAME_LENGTH = 56;
+const int PAK_ALIGN = 64;
+
+struct PakHeader
+{
+   char magic[4];
+   Uint32 count;
+   Uint32 reserved[2];
+};
+
+struct PakEntry
+{
+   char name[PAK_NAME_LENGTH];
+   Uint32 offset;
+   Uint32 size;
+};
+
+class PakFile
+{
+   private:
+      void *data;
+      size_t size;
+      const PakEntry *index;
+      int count;
+   public:
+      PakFile();
+      ~PakFile();
+      bool open(std::string filename);
+      void close();
+      const PakEntry *find(std::string name);
+      SDL_RWops *open_asset(std::string name);
+      const void *map_asset(std::string name, size_t *length);
+};
+
+PakFile::PakFile()
+{
+   data = NULL;
+   size = 0;
+   index = NULL;
+   count = 0;
+}
+
+PakFile::~PakFile()
+{
+   close();
+}
+
+bool PakFile::open(std::string filename)
+{
+   close();
+
+   int fd = ::open(filename.c_str(), O_RDONLY);
+   if (fd == -1)
+   {
+      return false;
+   }
+
+   struct stat info;
+   if ((fstat(fd, &info) == -1) || (info.st_size < (off_t)sizeof(PakHeader)))
+   {
+      ::close(fd);
+      return false;
+   }
+
+   void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if (mapped == MAP_FAILED)
+   {
+      return false;
+   }
+
+   const PakHeader *header = (const PakHeader*)mapped;
+   size_t indexEnd = sizeof(PakHeader) + (size_t)header->count * sizeof(PakEntry);
+   if ((memcmp(header->magic, PAK_MAGIC, 4) != 0) || (indexEnd > (size_t)info.st_size))
+   {
+      munmap(mapped, info.st_size);
+      return false;
+   }
+
+   data = mapped;
+   size = info.st_size;
+   index = (const PakEntry*)((const Uint8*)mapped + sizeof(PakHeader));
+   count = header->count;
+   return true;
+}
+
+void PakFile::close()
+{
+   if (data != NULL)
+   {
+      munmap(data, size);
+   }
+   data = NULL;
+   size = 0;
+   index = NULL;
+   count = 0;
+}
+
+const PakEntry *PakFile::find(std::string name)
+{
+   int low = 0, high = count;
+   while (low < high)
+   {
+      int middle = (low + high) / 2;
+      int order = strncmp(index[middle].name, name.c_str(), PAK_NAME_LENGTH);
+      if (order == 0)
+      {
+         const PakEntry *entry = &index[middle];
+         if ((size_t)entry->offset + entry->size > size)
+         {
+            return NULL;
+         }
+         return entry;
+      }
+      if (order < 0)
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
+      }
+   }
+   return NULL;
+}
+
+// NULL if the pak isn't open or doesn't have it
+SDL_RWops *PakFile::open_asset(std::string name)
+{
+   const PakEntry *entry = find(name);
+   if (entry == NULL)
+   {
+      return NULL;
+   }
+   return SDL_RWFromConstMem((const Uint8*)data + entry->offset, entry->size);
+}
+
+// the asset's bytes in the mapping, valid until close(), or NULL
+const void *PakFile::map_asset(std::string name, size_t *length)
+{
+   const PakEntry *entry = find(name);
+   if (entry == NULL)
+   {
+      return NULL;
+   }
+   *length = entry->size;
+   return (const Uint8*)data + entry->offset;
+}
+
+#endif
@@ -0,0 +1,357 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_mixer.h"
+#include "audio_mixer.h"
+#include "music_stream.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using std::cout;
+
+// how much is mixed at a time between events, like one device callback
+const int RENDER_BLOCK = 1024;
+
+struct Event
+{
+   // in output frames from the start
+   long frame;
+   std::string command;
+   std::string file;
+   int volume;
+};
+
+// Loads a WAV with SDL alone and converts it to 16 bit stereo at frequency,
+// the way Mix_LoadWAV would for an open device. NULL if it can't.
+Mix_Chunk *load_sound(std::string filename, int frequency)
+{
+   SDL_AudioSpec spec;
+   Uint8 *buffer = NULL;
+   Uint32 length = 0;
+   if (SDL_LoadWAV(filename.c_str(), &spec, &buffer, &length) == NULL)
+   {
+      return NULL;
+   }
+
+   SDL_AudioCVT convert;
+   if (SDL_BuildAudioCVT(&convert, spec.format, spec.channels, spec.freq, AUDIO_S16SYS, 2, frequency) == -1)
+   {
+      SDL_FreeWAV(buffer);
+      return NULL;
+   }
+   convert.len = length;
+   convert.buf = (Uint8*)malloc(length * convert.len_mult);
+   if (convert.buf == NULL)
+   {
+      SDL_FreeWAV(buffer);
+      SDL_SetError("Out of memory");
+      return NULL;
+   }
+   memcpy(convert.buf, buffer, length);
+   SDL_FreeWAV(buffer);
+   if (SDL_ConvertAudio(&convert) == -1)
+   {
+      free(convert.buf);
+      return NULL;
+   }
+
+   Mix_Chunk *chunk = (Mix_Chunk*)malloc(sizeof(Mix_Chunk));
+   if (chunk == NULL)
+   {
+      free(convert.buf);
+      SDL_SetError("Out of memory");
+      return NULL;
+   }
+   chunk->allocated = 1;
+   chunk->abuf = convert.buf;
+   chunk->alen = convert.len_cvt;
+   chunk->volume = MIX_MAX_VOLUME;
+   return chunk;
+}
+
+// One event a line: the time in ms, what happens, and for some a file and
+// a volume. Blank lines and lines starting with # are skipped.
+//
+//    0 music beat.wav
+//    250 play scratch.wav
+//    400 play high.wav 64
+//    2000 pause
+//    2500 resume
+//    4000 halt
+//    5000 end
+//
+// The output runs to the last event, so end is only there to give it a
+// length. Lines don't have to be in time order.
+bool earlier(const Event &a, const Event &b)
+{
+   return a.frame < b.frame;
+}
+
+bool read_script(std::string filename, int frequency, std::vector<Event> &events)
+{
+   std::ifstream script(filename.c_str());
+   if (script.is_open() == false)
+   {
+      cout << filename << ": could not read\n";
+      return false;
+   }
+
+   std::string line;
+   int number = 0;
+   while (std::getline(script, line))
+   {
+      number++;
+      std::stringstream fields(line);
+      long ms;
+      Event event;
+      event.volume = MIX_MAX_VOLUME;
+      if ((line.empty() == true) || (line[0] == '#') || !(fields >> ms))
+      {
+         continue;
+      }
+      fields >> event.command;
+      bool named = (event.command == "music") || (event.command == "play");
+      if ((named == true) && !(fields >> event.file))
+      {
+         cout << filename << ":" << number << ": " << event.command << " needs a file\n";
+         return false;
+      }
+      if ((event.command == "play") && !(fields >> event.volume))
+      {
+         event.volume = MIX_MAX_VOLUME;
+      }
+      if ((named == false) && (event.command != "pause") && (event.command != "resume") &&
+          (event.command != "halt") && (event.command != "end"))
+      {
+         cout << filename << ":" << number << ": no such command \"" << event.command << "\"\n";
+         return false;
+      }
+      event.frame = ms * frequency / 1000;
+      events.push_back(event);
+   }
+   // in time order, and lines with the same time in the order they were written
+   std::stable_sort(events.begin(), events.end(), earlier);
+   return true;
+}
+
+// the whole file as it goes on disk, which is always little endian
+void encode_wav(std::vector<Sint16> &samples, int frequency, std::vector<Uint8> &bytes)
+{
+   Uint32 data = samples.size() * 2;
+   bytes.assign(44 + data, 0);
+   Uint8 *header = &bytes[0];
+   memcpy(header, "RIFF", 4);
+   memcpy(header + 8, "WAVEfmt ", 8);
+   memcpy(header + 36, "data", 4);
+   Uint32 fields[] = { 36 + data, 16, 0, (Uint32)frequency, (Uint32)frequency * 4, 0, data };
+   int offsets[] = { 4, 16, 20, 24, 28, 32, 40 };
+   for (int i = 0; i < 7; i++)
+   {
+      for (int b = 0; b < 4; b++)
+      {
+         header[offsets[i] + b] = (fields[i] >> (b * 8)) & 0xFF;
+      }
+   }
+   // PCM, 2 channels, 4 byte frames, 16 bits
+   Uint8 format[] = { 1, 0, 2, 0 };
+   Uint8 block[] = { 4, 0, 16, 0 };
+   memcpy(header + 20, format, 4);
+   memcpy(header + 32, block, 4);
+
+   Uint8 *out = header + 44;
+   for (size_t i = 0; i < samples.size(); i++)
+   {
+      out[i * 2] = samples[i] & 0xFF;
+      out[i * 2 + 1] = (samples[i] >> 8) & 0xFF;
+   }
+}
+
+bool write_file(std::string filename, std::vector<Uint8> &bytes)
+{
+   FILE *file = fopen(filename.c_str(), "wb");
+   if (file == NULL)
+   {
+      return false;
+   }
+   bool ok = fwrite(&bytes[0], bytes.size(), 1, file) == 1;
+   if (fclose(file) != 0)
+   {
+      ok = false;
+   }
+   return ok;
+}
+
+bool read_file(std::string filename, std::vector<Uint8> &bytes)
+{
+   std::ifstream file(filename.c_str(), std::ios::binary);
+   if (file.is_open() == false)
+   {
+      return false;
+   }
+   bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+   return file.bad() == false;
+}
+
+// usage: render [--check] script.txt output.wav [frequency]
+// Plays a script of music and sound events through MusicStream and Mixer,
+// exactly as lesson 11's callback would, but without opening a device, and
+// writes what came out as a WAV. The same script always gives the same file,
+// so with --check output.wav is a known good render to compare against
+// instead of a file to write, e.g.
+//
+//    render --check session.txt session.wav 22050
+//
+// which fails when anything in the mixing path changed what comes out.
+int main(int argc, char* args[])
+{
+   bool check = (argc > 1) && (strcmp(args[1], "--check") == 0);
+   if (check == true)
+   {
+      argc--;
+      args++;
+   }
+   if ((argc != 3) && (argc != 4))
+   {
+      cout << "usage: " << args[0] << " [--check] script.txt output.wav [frequency]\n";
+      return 1;
+   }
+   int frequency = argc == 4 ? atoi(args[3]) : 44100;
+   if (frequency <= 0)
+   {
+      cout << args[3] << ": not a frequency\n";
+      return 1;
+   }
+
+   std::vector<Event> events;
+   if (read_script(args[1], frequency, events) == false)
+   {
+      return 1;
+   }
+
+   // everything a play can ask for is loaded before the clock starts
+   Mixer mixer;
+   MusicStream music;
+   music.set_frequency(frequency);
+   std::map<std::string, int> sounds;
+   std::vector<Mix_Chunk*> chunks;
+   long length = 0;
+   for (size_t i = 0; i < events.size(); i++)
+   {
+      if (events[i].frame > length)
+      {
+         length = events[i].frame;
+      }
+      if ((events[i].command == "play") && (sounds.find(events[i].file) == sounds.end()))
+      {
+         Mix_Chunk *chunk = load_sound(events[i].file, frequency);
+         if (chunk == NULL)
+         {
+            cout << events[i].file << ": " << SDL_GetError() << "\n";
+            return 1;
+         }
+         chunks.push_back(chunk);
+         sounds[events[i].file] = mixer.add_sound(chunk);
+      }
+   }
+
+   std::vector<Sint16> output(length * 2);
+   long frame = 0;
+   size_t next = 0;
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   while (frame < length)
+   {
+      // events land on their exact frame, blocks are cut short to get there
+      while ((next < events.size()) && (events[next].frame <= frame))
+      {
+         Event &event = events[next++];
+         if (event.command == "music")
+         {
+            if (music.open(event.file) == false)
+            {
+               cout << event.file << ": not a PCM WAV\n";
+               return 1;
+            }
+            music.play(true);
+         }
+         else if (event.command == "play")
+         {
+            mixer.play(sounds[event.file], event.volume);
+         }
+         else if (event.command == "pause")
+         {
+            music.pause();
+         }
+         else if (event.command == "resume")
+         {
+            music.resume();
+         }
+         else if (event.command == "halt")
+         {
+            music.halt();
+         }
+      }
+
+      long count = length - frame < RENDER_BLOCK ? length - frame : RENDER_BLOCK;
+      if ((next < events.size()) && (events[next].frame - frame < count))
+      {
+         count = events[next].frame - frame;
+      }
+      Sint16 *block = &output[frame * 2];
+      music.render(block, count);
+      mixer.mix(block, count);
+      frame += count;
+   }
+   double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+   std::vector<Uint8> wav;
+   encode_wav(output, frequency, wav);
+   int result = 0;
+   if (check == true)
+   {
+      std::vector<Uint8> expected;
+      if (read_file(args[2], expected) == false)
+      {
+         cout << args[2] << ": could not read\n";
+         return 1;
+      }
+      if (expected != wav)
+      {
+         // the header is the first 44 bytes, every frame after it is 4
+         size_t at = std::mismatch(wav.begin(), wav.begin() + std::min(wav.size(), expected.size()), expected.begin()).first - wav.begin();
+         long differs = at < 44 ? 0 : (long)(at - 44) / 4;
+         cout << args[2] << ": DIFFERS from frame " << differs << " (" << differs * 1000 / frequency << " ms), "
+              << expected.size() << " bytes expected, " << wav.size() << " rendered\n";
+         result = 1;
+      }
+      else
+      {
+         cout << args[2] << ": matches\n";
+      }
+   }
+   else if (write_file(args[2], wav) == false)
+   {
+      cout << args[2] << ": could not write\n";
+      return 1;
+   }
+
+   double played = (double)length / frequency;
+   cout << length << " frames (" << played << " s) at " << frequency << " Hz in " << seconds * 1000 << " ms, "
+        << (seconds > 0 ? length * 2 / seconds : 0) << " samples/s, " << (seconds > 0 ? played / seconds : 0) << "x real time\n";
+   mixer.report();
+
+   music.close();
+   for (size_t i = 0; i < chunks.size(); i++)
+   {
+      free(chunks[i]->abuf);
+      free(chunks[i]);
+   }
+   return result;
+}
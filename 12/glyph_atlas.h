@@ -0,0 +1,270 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+#include <vector>
+
+const int ATLAS_FIRST = 32;
+const int ATLAS_LAST = 126;
+const int ATLAS_GLYPHS = ATLAS_LAST - ATLAS_FIRST + 1;
+const int ATLAS_WIDTH = 512;
+// marks a kerning pair that hasn't been measured yet
+const signed char KERNING_UNKNOWN = 127;
+
+// Every printable ASCII glyph of one font in one color, rasterized once with
+// TTF_RenderGlyph_Solid into a single colorkeyed display format surface.
+// draw() lays a string out the way TTF_RenderText_Solid does, kerning
+// included, and blits it glyph by glyph, so it puts down the same pixels
+// without any FreeType work or surface allocation. Characters outside
+// 32..126 are skipped. The per-glyph calls let callers that keep their own
+// layout, like a text field, place one glyph at a time.
+class GlyphAtlas
+{
+   private:
+      struct Glyph
+      {
+         SDL_Rect clip;
+         int minx, maxx, maxy, advance;
+      };
+      TTF_Font *font;
+      SDL_Surface *atlas;
+      Glyph glyphs[ATLAS_GLYPHS];
+      int ascent, lineHeight;
+      bool kerning;
+      // SDL_ttf only hands out kerning by FreeType glyph index, so pairs are
+      // measured through TTF_SizeText the first time they are drawn
+      std::vector<signed char> pairs;
+   public:
+      GlyphAtlas(TTF_Font *ttf, SDL_Color color);
+      ~GlyphAtlas();
+      bool is_ready();
+      bool has_glyph(int ch);
+      int kern(int previous, int current);
+      int get_advance(int ch);
+      int get_left(int ch);
+      int get_right(int ch);
+      int width(const char *text);
+      int height();
+      void draw_glyph(int pen, int y, int ch, SDL_Surface *destination);
+      void draw(int x, int y, const char *text, SDL_Surface *destination);
+};
+
+GlyphAtlas::GlyphAtlas(TTF_Font *ttf, SDL_Color color)
+{
+   font = ttf;
+   atlas = NULL;
+   ascent = TTF_FontAscent(font);
+   lineHeight = TTF_FontHeight(font);
+   kerning = TTF_GetFontKerning(font) != 0;
+   pairs.assign(ATLAS_GLYPHS * ATLAS_GLYPHS, KERNING_UNKNOWN);
+
+   std::vector<SDL_Surface*> rendered(ATLAS_GLYPHS, (SDL_Surface*)NULL);
+   int x = 0, y = 0, shelf = 0;
+   for (int i = 0; i < ATLAS_GLYPHS; i++)
+   {
+      Glyph &glyph = glyphs[i];
+      int miny;
+      if (TTF_GlyphMetrics(font, ATLAS_FIRST + i, &glyph.minx, &glyph.maxx, &miny, &glyph.maxy, &glyph.advance) == -1)
+      {
+         glyph.minx = glyph.maxx = glyph.maxy = glyph.advance = 0;
+      }
+      glyph.clip.x = glyph.clip.y = 0;
+      glyph.clip.w = glyph.clip.h = 0;
+
+      rendered[i] = TTF_RenderGlyph_Solid(font, ATLAS_FIRST + i, color);
+      if (rendered[i] == NULL)
+      {
+         continue;
+      }
+
+      // shelves as tall as the tallest glyph on them
+      if (x + rendered[i]->w > ATLAS_WIDTH)
+      {
+         x = 0;
+         y += shelf;
+         shelf = 0;
+      }
+      glyph.clip.x = x;
+      glyph.clip.y = y;
+      glyph.clip.w = rendered[i]->w;
+      glyph.clip.h = rendered[i]->h;
+      x += rendered[i]->w;
+      if (rendered[i]->h > shelf)
+      {
+         shelf = rendered[i]->h;
+      }
+   }
+
+   SDL_PixelFormat *display = SDL_GetVideoSurface()->format;
+   atlas = SDL_CreateRGBSurface(SDL_SWSURFACE, ATLAS_WIDTH, y + shelf + 1, display->BitsPerPixel,
+                                display->Rmask, display->Gmask, display->Bmask, 0);
+
+   if (atlas != NULL)
+   {
+      // anything but the text color works as the key
+      Uint32 key = SDL_MapRGB(atlas->format, 255 - color.r, 255 - color.g, 255 - color.b);
+      SDL_FillRect(atlas, NULL, key);
+      for (int i = 0; i < ATLAS_GLYPHS; i++)
+      {
+         if (rendered[i] != NULL)
+         {
+            SDL_Rect offset = glyphs[i].clip;
+            SDL_BlitSurface(rendered[i], NULL, atlas, &offset);
+         }
+      }
+      SDL_SetColorKey(atlas, SDL_SRCCOLORKEY, key);
+   }
+
+   for (int i = 0; i < ATLAS_GLYPHS; i++)
+   {
+      SDL_FreeSurface(rendered[i]);
+   }
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+   SDL_FreeSurface(atlas);
+}
+
+bool GlyphAtlas::is_ready()
+{
+   return atlas != NULL;
+}
+
+bool GlyphAtlas::has_glyph(int ch)
+{
+   return (ch >= ATLAS_FIRST) && (ch <= ATLAS_LAST);
+}
+
+// the extra space between two glyphs, on top of the first one's advance
+int GlyphAtlas::kern(int previous, int current)
+{
+   if (kerning == false)
+   {
+      return 0;
+   }
+
+   signed char &k = pairs[(previous - ATLAS_FIRST) * ATLAS_GLYPHS + (current - ATLAS_FIRST)];
+   if (k == KERNING_UNKNOWN)
+   {
+      // undo everything TTF_SizeText adds around the two advances
+      char pair[3] = { (char)previous, (char)current, 0 };
+      int w = 0;
+      TTF_SizeText(font, pair, &w, NULL);
+      Glyph &a = glyphs[previous - ATLAS_FIRST];
+      Glyph &b = glyphs[current - ATLAS_FIRST];
+      int left = a.minx < 0 ? a.minx : 0;
+      int right = b.advance > b.maxx ? b.advance : b.maxx;
+      k = w + left - a.advance - right;
+   }
+   return k;
+}
+
+int GlyphAtlas::get_advance(int ch)
+{
+   return glyphs[ch - ATLAS_FIRST].advance;
+}
+
+// where the ink starts, relative to the pen
+int GlyphAtlas::get_left(int ch)
+{
+   return glyphs[ch - ATLAS_FIRST].minx;
+}
+
+// how far right of the pen the glyph reaches, ink or advance
+int GlyphAtlas::get_right(int ch)
+{
+   Glyph &glyph = glyphs[ch - ATLAS_FIRST];
+   return glyph.advance > glyph.maxx ? glyph.advance : glyph.maxx;
+}
+
+// the same as the width TTF_SizeText would give
+int GlyphAtlas::width(const char *text)
+{
+   int pen = 0, left = 0, right = 0, previous = 0;
+   for (const char *c = text; *c != '\0'; c++)
+   {
+      int ch = (unsigned char)*c;
+      if (has_glyph(ch) == false)
+      {
+         continue;
+      }
+      if (previous != 0)
+      {
+         pen += kern(previous, ch);
+      }
+      if (pen + get_left(ch) < left)
+      {
+         left = pen + get_left(ch);
+      }
+      if (pen + get_right(ch) > right)
+      {
+         right = pen + get_right(ch);
+      }
+      pen += get_advance(ch);
+      previous = ch;
+   }
+   return right - left;
+}
+
+int GlyphAtlas::height()
+{
+   return lineHeight;
+}
+
+// draws one glyph with its pen at x = pen on a line whose top is y
+void GlyphAtlas::draw_glyph(int pen, int y, int ch, SDL_Surface *destination)
+{
+   Glyph &glyph = glyphs[ch - ATLAS_FIRST];
+
+   // rows above or below the line box never make it into the text surface
+   SDL_Rect clip = glyph.clip;
+   int top = ascent - glyph.maxy;
+   if (top < 0)
+   {
+      clip.y -= top;
+      clip.h += top;
+      top = 0;
+   }
+   if (top + clip.h > lineHeight)
+   {
+      clip.h = lineHeight - top;
+   }
+
+   if ((clip.w > 0) && (clip.h > 0))
+   {
+      SDL_Rect offset;
+      offset.x = pen + glyph.minx;
+      offset.y = y + top;
+      SDL_BlitSurface(atlas, &clip, destination, &offset);
+   }
+}
+
+// x and y are where the top left of the TTF_RenderText_Solid surface would go
+void GlyphAtlas::draw(int x, int y, const char *text, SDL_Surface *destination)
+{
+   int pen = x, previous = 0;
+   for (const char *c = text; *c != '\0'; c++)
+   {
+      int ch = (unsigned char)*c;
+      if (has_glyph(ch) == false)
+      {
+         continue;
+      }
+      if (previous != 0)
+      {
+         pen += kern(previous, ch);
+      }
+      // SDL_ttf shifts the whole line right when the first glyph hangs left
+      if ((previous == 0) && (get_left(ch) < 0))
+      {
+         pen -= get_left(ch);
+      }
+      draw_glyph(pen, y, ch, destination);
+      pen += get_advance(ch);
+      previous = ch;
+   }
+}
+
+#endif
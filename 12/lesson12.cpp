@@ -1,8 +1,9 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "glyph_atlas.h"
+#include "number_text.h"
 #include <string>
-#include <sstream>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -10,8 +11,9 @@ const int SCREEN_BPP = 32;
 
 SDL_Surface *info = NULL;
 SDL_Surface *screen = NULL;
-SDL_Surface *seconds = NULL;
 TTF_Font *font = NULL;
+GlyphAtlas *glyphs = NULL;
+NumberText *timerText = NULL;
 SDL_Event event;
 SDL_Color textColor = {255, 255, 255};
 
@@ -40,7 +42,7 @@ SDL_Surface *load_image(std::string filename)
 
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -70,11 +72,21 @@ bool load_files()
       return 1;
    }
 
+   // the timer changes every frame, so it is drawn from prerendered glyphs
+   glyphs = new GlyphAtlas(font, textColor);
+   if (glyphs->is_ready() == false)
+   {
+      return false;
+   }
+   timerText = new NumberText(glyphs, "Timer: ");
+
    return true;
 }
 
 void clean_up()
 {
+   delete timerText;
+   delete glyphs;
    TTF_CloseFont(font);
    
    TTF_Quit();
@@ -133,11 +145,8 @@ int main(int argc, char* args[])
         
       if (running == true)
       {
-         std::stringstream time;
-         time << "Timer: " << SDL_GetTicks() - start;
-         seconds = TTF_RenderText_Solid(font, time.str().c_str(), textColor);
-         apply_surface((SCREEN_WIDTH, seconds->w) / 2, 50, seconds, screen);
-         SDL_FreeSurface(seconds);
+         timerText->set(SDL_GetTicks() - start);
+         timerText->draw((SCREEN_WIDTH - timerText->width()) / 2, 50, screen);
       }
       if (SDL_Flip(screen) == -1)
       {
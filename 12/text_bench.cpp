@@ -0,0 +1,212 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+#include "glyph_atlas.h"
+#include "number_text.h"
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <iostream>
+
+using std::cout;
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+const int SCREEN_BPP = 32;
+const int FRAMES = 20000;
+
+SDL_Surface *screen = NULL;
+SDL_Surface *target = NULL;
+SDL_Surface *check = NULL;
+TTF_Font *font = NULL;
+SDL_Color textColor = {255, 255, 255};
+
+// Every malloc, calloc and realloc in the process goes through here, SDL's
+// and FreeType's included, so a frame that doesn't move this allocated
+// nothing at all. Only glibc lets us sit in front of its allocator.
+long allocations = 0;
+
+#ifdef __GLIBC__
+extern "C"
+{
+   void *__libc_malloc(size_t size);
+   void *__libc_calloc(size_t count, size_t size);
+   void *__libc_realloc(void *pointer, size_t size);
+
+   void *malloc(size_t size)
+   {
+      allocations++;
+      return __libc_malloc(size);
+   }
+
+   void *calloc(size_t count, size_t size)
+   {
+      allocations++;
+      return __libc_calloc(count, size);
+   }
+
+   void *realloc(void *pointer, size_t size)
+   {
+      allocations++;
+      return __libc_realloc(pointer, size);
+   }
+}
+#endif
+
+// what lesson 12 shows on frame i
+std::string timer_text(int i)
+{
+   std::stringstream time;
+   time << "Timer: " << i * 16;
+   return time.str();
+}
+
+void report(std::string name, Uint32 ms, long allocated)
+{
+   cout << "   " << name << ": " << ms << " ms";
+   if (ms > 0)
+   {
+      cout << ", " << (FRAMES * 1000.0) / ms << " strings/s";
+   }
+   cout << ", " << allocated << " allocations\n";
+}
+
+bool same_pixels(SDL_Surface* a, SDL_Surface* b)
+{
+   for (int y = 0; y < a->h; y++)
+   {
+      if (memcmp((Uint8*)a->pixels + y * a->pitch, (Uint8*)b->pixels + y * b->pitch, a->w * a->format->BytesPerPixel) != 0)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// draws each string both ways and compares, so the timing below is for the same output
+bool compare(GlyphAtlas &glyphs, std::string text)
+{
+   SDL_FillRect(target, NULL, 0);
+   SDL_FillRect(check, NULL, 0);
+
+   SDL_Surface *rendered = TTF_RenderText_Solid(font, text.c_str(), textColor);
+   if (rendered == NULL)
+   {
+      return false;
+   }
+   SDL_Rect offset;
+   offset.x = 20;
+   offset.y = 20;
+   SDL_BlitSurface(rendered, NULL, target, &offset);
+   bool sameWidth = rendered->w == glyphs.width(text.c_str());
+   SDL_FreeSurface(rendered);
+
+   glyphs.draw(20, 20, text.c_str(), check);
+
+   bool same = sameWidth && same_pixels(target, check);
+   cout << "   \"" << text << "\" " << (same ? "identical" : "DIFFERS") << "\n";
+   return same;
+}
+
+int main(int argc, char* args[])
+{
+   // no window is needed, only a display format to convert to
+   SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return 1;
+   }
+
+   if (TTF_Init() == -1)
+   {
+      return 1;
+   }
+
+   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+   if (screen == NULL)
+   {
+      return 1;
+   }
+
+   target = SDL_DisplayFormat(screen);
+   check = SDL_DisplayFormat(screen);
+   font = TTF_OpenFont("lazy.ttf", 28);
+   if ((target == NULL) || (check == NULL) || (font == NULL))
+   {
+      return 1;
+   }
+
+   Uint32 start = SDL_GetTicks();
+   GlyphAtlas *atlas = new GlyphAtlas(font, textColor);
+   GlyphAtlas &glyphs = *atlas;
+   if (glyphs.is_ready() == false)
+   {
+      return 1;
+   }
+   cout << "building the atlas: " << SDL_GetTicks() - start << " ms\n";
+
+   bool passed = true;
+   passed = compare(glyphs, "Timer: 1234567890") && passed;
+   passed = compare(glyphs, "Timer: 12.345") && passed;
+   passed = compare(glyphs, "AVAST Ty. WAVE fjord") && passed;
+   passed = compare(glyphs, "Press p to pause") && passed;
+
+   cout << FRAMES << " timer strings\n";
+
+   long before = allocations;
+   start = SDL_GetTicks();
+   for (int i = 0; i < FRAMES; i++)
+   {
+      std::string text = timer_text(i);
+      SDL_Surface *seconds = TTF_RenderText_Solid(font, text.c_str(), textColor);
+      SDL_Rect offset;
+      offset.x = (SCREEN_WIDTH - seconds->w) / 2;
+      offset.y = 50;
+      SDL_BlitSurface(seconds, NULL, target, &offset);
+      SDL_FreeSurface(seconds);
+   }
+   report("TTF_RenderText_Solid per frame", SDL_GetTicks() - start, allocations - before);
+
+   before = allocations;
+   start = SDL_GetTicks();
+   for (int i = 0; i < FRAMES; i++)
+   {
+      std::string text = timer_text(i);
+      glyphs.draw((SCREEN_WIDTH - glyphs.width(text.c_str())) / 2, 50, text.c_str(), target);
+   }
+   report("GlyphAtlas", SDL_GetTicks() - start, allocations - before);
+
+   NumberText timerText(atlas, "Timer: ");
+   // measures every kerning pair a counter can run into before the steady state
+   for (int i = 0; i < 1000; i++)
+   {
+      timerText.set(i);
+      timerText.draw(0, 0, target);
+   }
+
+   before = allocations;
+   start = SDL_GetTicks();
+   for (int i = 0; i < FRAMES; i++)
+   {
+      timerText.set(i * 16);
+      timerText.draw((SCREEN_WIDTH - timerText.width()) / 2, 50, target);
+   }
+   long steady = allocations - before;
+   report("NumberText", SDL_GetTicks() - start, steady);
+
+#ifdef __GLIBC__
+   if (steady != 0)
+   {
+      cout << "NumberText allocated in the steady state\n";
+      passed = false;
+   }
+#endif
+
+   delete atlas;
+   TTF_CloseFont(font);
+   SDL_FreeSurface(check);
+   SDL_FreeSurface(target);
+   TTF_Quit();
+   SDL_Quit();
+   return passed ? 0 : 1;
+}
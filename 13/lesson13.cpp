@@ -1,8 +1,10 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "glyph_atlas.h"
+#include "number_text.h"
 #include <string>
-#include <sstream>
+#include <time.h>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -11,18 +13,22 @@ const int SCREEN_BPP = 32;
 SDL_Surface *startStop = NULL;
 SDL_Surface *pauseMessage = NULL;
 SDL_Surface *screen = NULL;
-SDL_Surface *seconds = NULL;
 TTF_Font *font = NULL;
+GlyphAtlas *glyphs = NULL;
+NumberText *timerText = NULL;
 SDL_Event event;
 SDL_Color textColor = {255, 255, 255};
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -30,23 +36,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -55,28 +70,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -85,8 +111,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -128,7 +154,7 @@ SDL_Surface *load_image(std::string filename)
 
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -158,11 +184,22 @@ bool load_files()
       return 1;
    }
 
+   // the timer changes every frame, so it is drawn from prerendered glyphs
+   glyphs = new GlyphAtlas(font, textColor);
+   if (glyphs->is_ready() == false)
+   {
+      return false;
+   }
+   // ticks are milliseconds, so three places show seconds
+   timerText = new NumberText(glyphs, "Timer: ", 3);
+
    return true;
 }
 
 void clean_up()
 {
+   delete timerText;
+   delete glyphs;
    TTF_CloseFont(font);
    
    TTF_Quit();
@@ -231,11 +268,8 @@ int main(int argc, char* args[])
         
       if (myTimer.is_started())
       {
-         std::stringstream time;
-         time << "Timer: " << myTimer.get_ticks() / 1000.f;
-         seconds = TTF_RenderText_Solid(font, time.str().c_str(), textColor);
-         apply_surface((SCREEN_WIDTH, seconds->w) / 2, 50, seconds, screen);
-         SDL_FreeSurface(seconds);
+         timerText->set(myTimer.get_ticks());
+         timerText->draw((SCREEN_WIDTH - timerText->width()) / 2, 50, screen);
          if (SDL_Flip(screen) == -1)
          {
             return 1;
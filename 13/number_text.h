@@ -0,0 +1,140 @@
+#ifndef NUMBER_TEXT_H
+#define NUMBER_TEXT_H
+
+#include "SDL/SDL.h"
+#include "glyph_atlas.h"
+#include <cstring>
+
+// a label of up to 32 characters and then any long with its point
+const int NUMBER_TEXT_SIZE = 64;
+
+// Writes value in decimal with no leading zeros and returns the length.
+// buffer needs room for 21 characters.
+int format_int(char *buffer, long value)
+{
+   char digits[24];
+   int count = 0;
+   // work in unsigned so the most negative value doesn't overflow
+   unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+   do
+   {
+      digits[count++] = '0' + magnitude % 10;
+      magnitude /= 10;
+   } while (magnitude != 0);
+
+   int length = 0;
+   if (value < 0)
+   {
+      buffer[length++] = '-';
+   }
+   while (count > 0)
+   {
+      buffer[length++] = digits[--count];
+   }
+   buffer[length] = '\0';
+   return length;
+}
+
+// Writes value / 10^decimals with exactly that many places after the point,
+// so 12345 with 3 decimals is "12.345" and 5 is "0.005".
+int format_fixed(char *buffer, long value, int decimals)
+{
+   if (decimals <= 0)
+   {
+      return format_int(buffer, value);
+   }
+
+   char digits[24];
+   int count = format_int(digits, value);
+   int sign = (value < 0) ? 1 : 0;
+   int length = 0;
+   if (sign == 1)
+   {
+      buffer[length++] = '-';
+   }
+
+   // pad with zeros until there is at least one digit before the point
+   int whole = count - sign - decimals;
+   if (whole <= 0)
+   {
+      buffer[length++] = '0';
+      buffer[length++] = '.';
+      for (int i = whole; i < 0; i++)
+      {
+         buffer[length++] = '0';
+      }
+      for (int i = sign; i < count; i++)
+      {
+         buffer[length++] = digits[i];
+      }
+   }
+   else
+   {
+      for (int i = sign; i < count; i++)
+      {
+         if (i - sign == whole)
+         {
+            buffer[length++] = '.';
+         }
+         buffer[length++] = digits[i];
+      }
+   }
+   buffer[length] = '\0';
+   return length;
+}
+
+// A label followed by a number, kept in a fixed buffer and drawn from a
+// GlyphAtlas. Changing the number only rewrites the digits after the label,
+// so a counter that updates every frame never touches the heap.
+class NumberText
+{
+   private:
+      GlyphAtlas *glyphs;
+      char text[NUMBER_TEXT_SIZE];
+      int prefix;
+      int decimals;
+      int textWidth;
+   public:
+      NumberText(GlyphAtlas *atlas, const char *label, int places = 0);
+      void set(long value);
+      const char *get_text();
+      int width();
+      void draw(int x, int y, SDL_Surface *destination);
+};
+
+NumberText::NumberText(GlyphAtlas *atlas, const char *label, int places)
+{
+   glyphs = atlas;
+   decimals = places < 0 ? 0 : (places > 9 ? 9 : places);
+   // leave room for the number after the label
+   prefix = strlen(label);
+   if (prefix > NUMBER_TEXT_SIZE - 32)
+   {
+      prefix = NUMBER_TEXT_SIZE - 32;
+   }
+   memcpy(text, label, prefix);
+   set(0);
+}
+
+void NumberText::set(long value)
+{
+   format_fixed(text + prefix, value, decimals);
+   textWidth = glyphs->width(text);
+}
+
+const char *NumberText::get_text()
+{
+   return text;
+}
+
+int NumberText::width()
+{
+   return textWidth;
+}
+
+void NumberText::draw(int x, int y, SDL_Surface *destination)
+{
+   glyphs->draw(x, y, text, destination);
+}
+
+#endif
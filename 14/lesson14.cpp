@@ -1,7 +1,9 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "bitmap_font.h"
 #include <string>
+#include <time.h>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -12,6 +14,7 @@ SDL_Surface *screen = NULL;
 SDL_Surface *background = NULL;
 SDL_Surface *message = NULL;
 TTF_Font *font = NULL;
+BitmapFont bakedFont;
 SDL_Event event;
 SDL_Color textColor = {255,255,255};
 
@@ -38,17 +41,38 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
-bool init()
+// baked ahead of time with "../07/fontbake lazy.ttf 28 lazy28.fnt", FreeType only
+// starts up when that file is missing or older than lazy.ttf
+bool load_font()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (bakedFont.open("lazy28.fnt", "lazy.ttf") == true)
    {
-      return false;
+      return true;
    }
 
    if (TTF_Init() == -1)
    {
       return false;
    }
+   font = TTF_OpenFont("lazy.ttf", 28);
+   return font != NULL;
+}
+
+SDL_Surface *render_text(const char *text)
+{
+   if (bakedFont.is_open() == true)
+   {
+      return bakedFont.render(text, textColor);
+   }
+   return TTF_RenderText_Solid(font, text, textColor);
+}
+
+bool init()
+{
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return false;
+   }
 
    screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
 
@@ -70,10 +94,9 @@ bool load_files()
       return 1;
    }
 
-   font = TTF_OpenFont("lazy.ttf", 28);
-   if (font == NULL)
+   if (load_font() == false)
    {
-      return 1;
+      return false;
    }
 
    return true;
@@ -89,25 +112,112 @@ void clean_up()
    SDL_Quit();
 }
 
-class Timer 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
+class Timer
 {
    private:
-      Uint8 start_ticks;
+      long long startNanos;
+      long long pausedNanos;
+      bool paused;
+      bool started;
+      static long long now();
    public:
-     Uint8 get_ticks();
-     void start();
+      Timer();
+      void start();
+      void stop();
+      void pause();
+      void unpause();
+      int get_ticks();
+      long long get_micros();
+      long long get_nanos();
+      bool is_started();
+      bool is_paused();
 };
 
-void Timer::start() 
+Timer::Timer()
+{
+   startNanos = 0;
+   pausedNanos = 0;
+   paused = false;
+   started = false;
+}
+
+long long Timer::now()
 {
-   start_ticks = SDL_GetTicks();
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
 }
 
-Uint8 Timer::get_ticks()
+void Timer::start()
 {
-   return (SDL_GetTicks() - start_ticks);
+   started = true;
+   paused = false;
+   startNanos = now();
 }
 
+void Timer::stop()
+{
+   started = false;
+   paused = false;
+}
+
+long long Timer::get_nanos()
+{
+   if(started == true)
+   {
+      if (paused == true)
+      {
+         return pausedNanos;
+      }
+      else
+      {
+         return now() - startNanos;
+      }
+   }
+   return 0;
+}
+
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
+void Timer::pause()
+{
+   if ((started == true) && (paused == false))
+   {
+      paused = true;
+      pausedNanos = now() - startNanos;
+   }
+}
+
+void Timer::unpause()
+{
+   if (paused == true)
+   {
+      paused = false;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
+   }
+}
+
+bool Timer::is_started()
+{
+   return started;
+}
+
+bool Timer::is_paused()
+{
+   return paused;
+}
 
 int main(int argc, char* args[])
 {
@@ -127,7 +237,7 @@ int main(int argc, char* args[])
       return 1;
    }
 
-   message = TTF_RenderText_Solid(font, "Testing Frame Rate", textColor);
+   message = render_text("Testing Frame Rate");
 
    while(quit == false)
    {
@@ -155,9 +265,12 @@ int main(int argc, char* args[])
          return 1;
       }
       frame++;
-      if ((cap == true) && (fps.get_ticks() < 1000 / FRAMES_PER_SECOND))
+      // rounded up to the next millisecond, a frame a fraction of a
+      // millisecond long is cheaper than spinning the CPU to be exact
+      long long frameMicros = 1000000 / FRAMES_PER_SECOND;
+      if ((cap == true) && (fps.get_micros() < frameMicros))
       {
-         SDL_Delay((1000/FRAMES_PER_SECOND) - fps.get_ticks());
+         SDL_Delay((frameMicros - fps.get_micros() + 999) / 1000);
       }
    }
    clean_up();
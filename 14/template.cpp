@@ -1,6 +1,7 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "bitmap_font.h"
 #include <string>
 
 const int SCREEN_WIDTH = 640;
@@ -11,6 +12,7 @@ const int FRAMES_PER_SECOND = 20;
 SDL_Surface *screen = NULL;
 SDL_Surface *background = NULL;
 TTF_Font *font = NULL;
+BitmapFont bakedFont;
 SDL_Event event;
 SDL_Color textColor = {255,255,255};
 
@@ -37,17 +39,38 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
-bool init()
+// baked ahead of time with "../07/fontbake lazy.ttf 28 lazy28.fnt", FreeType only
+// starts up when that file is missing or older than lazy.ttf
+bool load_font()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (bakedFont.open("lazy28.fnt", "lazy.ttf") == true)
    {
-      return false;
+      return true;
    }
 
    if (TTF_Init() == -1)
    {
       return false;
    }
+   font = TTF_OpenFont("lazy.ttf", 28);
+   return font != NULL;
+}
+
+SDL_Surface *render_text(const char *text)
+{
+   if (bakedFont.is_open() == true)
+   {
+      return bakedFont.render(text, textColor);
+   }
+   return TTF_RenderText_Solid(font, text, textColor);
+}
+
+bool init()
+{
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return false;
+   }
 
    screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
 
@@ -69,10 +92,9 @@ bool load_files()
       return 1;
    }
 
-   font = TTF_OpenFont("lazy.ttf", 28);
-   if (font == NULL)
+   if (load_font() == false)
    {
-      return 1;
+      return false;
    }
 
    return true;
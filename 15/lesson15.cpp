@@ -1,8 +1,10 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "glyph_atlas.h"
+#include "number_text.h"
 #include <string>
-#include <sstream>
+#include <time.h>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
@@ -11,16 +13,21 @@ const int SCREEN_BPP = 32;
 SDL_Surface *screen = NULL;
 SDL_Surface *image = NULL;
 TTF_Font *font = NULL;
+GlyphAtlas *glyphs = NULL;
+NumberText *fpsText = NULL;
 SDL_Event event;
 SDL_Color textColor = {255, 255, 255};
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -28,23 +35,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -53,28 +69,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -83,8 +110,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -123,7 +150,7 @@ SDL_Surface *load_image(std::string filename)
 
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -160,11 +187,21 @@ bool load_files()
       return 1;
    }
 
+   glyphs = new GlyphAtlas(font, textColor);
+   if (glyphs->is_ready() == false)
+   {
+      return false;
+   }
+   // hundredths of a frame per second
+   fpsText = new NumberText(glyphs, "Average Frames Per Second: ", 2);
+
    return true;
 }
 
 void clean_up()
 {
+   delete fpsText;
+   delete glyphs;
    TTF_CloseFont(font);
    
    TTF_Quit();
@@ -203,6 +240,7 @@ int main(int argc, char* args[])
       }
 
       apply_surface(0, 0, image, screen);
+      fpsText->draw(10, 10, screen);
 
       if (SDL_Flip(screen) == -1)
       {
@@ -211,9 +249,8 @@ int main(int argc, char* args[])
       frame++;
       if (update.get_ticks() > 1000)
       {
-         std::stringstream caption;
-         caption << "Average Frames Per Second: " << frame / (fps.get_ticks() / 1000.f);
-         SDL_WM_SetCaption(caption.str().c_str(), NULL);
+         fpsText->set(frame * 100000000LL / fps.get_micros());
+         SDL_WM_SetCaption(fpsText->get_text(), NULL);
          update.start();
       }
    }
@@ -4,6 +4,7 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <time.h>
 
 const int FRAMES_PER_SECOND = 20;
 const int SCREEN_WIDTH = 640;
@@ -13,16 +14,42 @@ const int DOT_HEIGHT = 20;
 const int DOT_WIDTH = 2;
 
 SDL_Surface *screen = NULL;
+SDL_Surface *background = NULL;
 SDL_Surface *dot = NULL;
 
 SDL_Event event;
 
+class DirtyRects
+{
+   private:
+      std::vector<SDL_Rect> drawn;
+      std::vector<SDL_Rect> previous;
+      std::vector<SDL_Rect> update;
+      int pixels;
+      long long totalPixels;
+      int frames;
+   public:
+      DirtyRects();
+      void add(SDL_Rect rect);
+      void restore(SDL_Surface* backdrop, SDL_Surface* destination);
+      void present(SDL_Surface* destination);
+      int get_pixels();
+      void report();
+};
+
+DirtyRects dirty;
+
 void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
 {
    SDL_Rect offset;
    offset.x = x;
    offset.y = y;
    SDL_BlitSurface(source, clip, destination, &offset);
+   // the blit leaves the clipped bounds it actually wrote in offset
+   if (destination == screen)
+   {
+      dirty.add(offset);
+   }
 }
 
 SDL_Surface *load_image(std::string filename)
@@ -55,13 +82,16 @@ class Dot
       std::vector<SDL_Rect> &get_rects();
 };
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -69,23 +99,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -94,28 +133,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -124,8 +174,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -307,9 +357,78 @@ std::vector<SDL_Rect> &Dot::get_rects()
    return box;
 }
 
+DirtyRects::DirtyRects()
+{
+   pixels = 0;
+   totalPixels = 0;
+   frames = 0;
+}
+
+void DirtyRects::add(SDL_Rect rect)
+{
+   if ((rect.w > 0) && (rect.h > 0))
+   {
+      drawn.push_back(rect);
+   }
+}
+
+void DirtyRects::restore(SDL_Surface* backdrop, SDL_Surface* destination)
+{
+   // put the background back wherever something was drawn last frame
+   for (size_t i = 0; i < previous.size(); i++)
+   {
+      SDL_Rect source = previous[i];
+      SDL_Rect offset = previous[i];
+      SDL_BlitSurface(backdrop, &source, destination, &offset);
+      update.push_back(previous[i]);
+   }
+   previous.clear();
+}
+
+void DirtyRects::present(SDL_Surface* destination)
+{
+   for (size_t i = 0; i < drawn.size(); i++)
+   {
+      update.push_back(drawn[i]);
+   }
+
+   pixels = 0;
+   for (size_t i = 0; i < update.size(); i++)
+   {
+      pixels += update[i].w * update[i].h;
+   }
+   totalPixels += pixels;
+   frames++;
+
+   if (update.empty() == false)
+   {
+      SDL_UpdateRects(destination, update.size(), &update[0]);
+   }
+
+   // what was drawn this frame is what has to be erased next frame
+   previous.swap(drawn);
+   drawn.clear();
+   update.clear();
+}
+
+int DirtyRects::get_pixels()
+{
+   return pixels;
+}
+
+// once at exit, a line a frame would flood the terminal
+void DirtyRects::report()
+{
+   if (frames > 0)
+   {
+      std::cout << "Pixels touched: " << totalPixels / frames << " a frame on average over " << frames
+                << " frames, out of " << SCREEN_WIDTH * SCREEN_HEIGHT << "\n";
+   }
+}
+
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -334,12 +453,21 @@ bool load_files()
       return 1;
    }
 
+   background = SDL_CreateRGBSurface(SDL_SWSURFACE, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, screen->format->Rmask, screen->format->Gmask, screen->format->Bmask, screen->format->Amask);
+   if (background == NULL)
+   {
+      return false;
+   }
+   SDL_FillRect(background, &background->clip_rect, SDL_MapRGB(background->format, 0xFF, 0xFF, 0xFF));
+
    return true;
 }
 
 void clean_up()
 {
+   dirty.report();
    SDL_FreeSurface(dot);;
+   SDL_FreeSurface(background);
    
    SDL_Quit();
 }
@@ -362,6 +490,12 @@ int main(int argc, char* args[])
 
    Dot myDot(0, 0), otherDot(20, 20);
 
+   SDL_BlitSurface(background, NULL, screen, NULL);
+   if (SDL_Flip(screen) == -1)
+   {
+      return 1;
+   }
+
    while(quit == false)
    {
       fps.start();
@@ -377,19 +511,17 @@ int main(int argc, char* args[])
 
       myDot.move(otherDot.get_rects());
 
-      SDL_FillRect(screen, &screen->clip_rect, SDL_MapRGB(screen->format, 0xFF, 0xFF, 0xFF));
+      dirty.restore(background, screen);
 
       otherDot.show();
       myDot.show();
 
-      if (SDL_Flip(screen) == -1)
-      {
-         return 1;
-      }
+      dirty.present(screen);
 
-      if (fps.get_ticks() < 1000 / FRAMES_PER_SECOND)
+      long long frameMicros = 1000000 / FRAMES_PER_SECOND;
+      if (fps.get_micros() < frameMicros)
       {
-         SDL_Delay((1000/FRAMES_PER_SECOND) - fps.get_ticks());
+         SDL_Delay((frameMicros - fps.get_micros() + 999) / 1000);
       }
    }
    clean_up();
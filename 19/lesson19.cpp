@@ -5,6 +5,8 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <time.h>
 
 using std::cout;
 
@@ -20,6 +22,7 @@ const int DOT_WIDTH = 20;
 SDL_Surface *screen = NULL;
 SDL_Surface *square = NULL;
 SDL_Surface *dot = NULL;
+SDL_Surface *background = NULL;
 
 SDL_Rect wall;
 SDL_Event event;
@@ -30,14 +33,177 @@ struct Circle
    int r;
 };
 
+class DirtyRects
+{
+   private:
+      std::vector<SDL_Rect> drawn;
+      std::vector<SDL_Rect> previous;
+      std::vector<SDL_Rect> update;
+      int pixels;
+      long long totalPixels;
+      int frames;
+   public:
+      DirtyRects();
+      void add(SDL_Rect rect);
+      void restore(SDL_Surface* backdrop, SDL_Surface* destination);
+      void present(SDL_Surface* destination);
+      int get_pixels();
+      void report();
+};
+
+DirtyRects dirty;
+
 void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
 {
    SDL_Rect offset;
    offset.x = x;
    offset.y = y;
    SDL_BlitSurface(source, clip, destination, &offset);
+   // the blit leaves the clipped bounds it actually wrote in offset
+   if (destination == screen)
+   {
+      dirty.add(offset);
+   }
+}
+
+struct SpriteCommand
+{
+   SDL_Surface *source;
+   int z;
+   SDL_Rect clip;
+   int x, y;
+};
+
+bool sprite_order(const SpriteCommand &A, const SpriteCommand &B)
+{
+   if (A.z != B.z)
+   {
+      return A.z < B.z;
+   }
+   return A.source < B.source;
+}
+
+class SpriteBatch
+{
+   private:
+      std::vector<SpriteCommand> commands;
+   public:
+      void add(int x, int y, SDL_Surface* source, SDL_Rect* clip = NULL, int z = 0);
+      void draw(SDL_Surface* destination);
+      int size();
+};
+
+void SpriteBatch::add(int x, int y, SDL_Surface* source, SDL_Rect* clip, int z)
+{
+   SpriteCommand command;
+   command.source = source;
+   command.z = z;
+   command.x = x;
+   command.y = y;
+   if (clip != NULL)
+   {
+      command.clip = *clip;
+   }
+   else
+   {
+      command.clip.x = 0;
+      command.clip.y = 0;
+      command.clip.w = source->w;
+      command.clip.h = source->h;
+   }
+   commands.push_back(command);
+}
+
+void SpriteBatch::draw(SDL_Surface* destination)
+{
+   // keep layering by z, then group sprites that share a surface
+   std::stable_sort(commands.begin(), commands.end(), sprite_order);
+
+   // this is the clipping SDL_BlitSurface would redo on every call
+   int left = destination->clip_rect.x;
+   int top = destination->clip_rect.y;
+   int right = left + destination->clip_rect.w;
+   int bottom = top + destination->clip_rect.h;
+
+   size_t i = 0;
+   while (i < commands.size())
+   {
+      SDL_Surface *source = commands[i].source;
+      int sourceW = source->w;
+      int sourceH = source->h;
+
+      for (; (i < commands.size()) && (commands[i].source == source); i++)
+      {
+         SpriteCommand &c = commands[i];
+         int sx = c.clip.x, sy = c.clip.y;
+         int w = c.clip.w, h = c.clip.h;
+         int dx = c.x, dy = c.y;
+
+         if (sx < 0)
+         {
+            w += sx;
+            dx -= sx;
+            sx = 0;
+         }
+         if (sy < 0)
+         {
+            h += sy;
+            dy -= sy;
+            sy = 0;
+         }
+         if (sx + w > sourceW)
+         {
+            w = sourceW - sx;
+         }
+         if (sy + h > sourceH)
+         {
+            h = sourceH - sy;
+         }
+
+         if (dx < left)
+         {
+            sx += left - dx;
+            w -= left - dx;
+            dx = left;
+         }
+         if (dy < top)
+         {
+            sy += top - dy;
+            h -= top - dy;
+            dy = top;
+         }
+         if (dx + w > right)
+         {
+            w = right - dx;
+         }
+         if (dy + h > bottom)
+         {
+            h = bottom - dy;
+         }
+
+         if ((w > 0) && (h > 0))
+         {
+            SDL_Rect src = { (Sint16)sx, (Sint16)sy, (Uint16)w, (Uint16)h };
+            SDL_Rect dst = { (Sint16)dx, (Sint16)dy, (Uint16)w, (Uint16)h };
+            SDL_LowerBlit(source, &src, destination, &dst);
+            if (destination == screen)
+            {
+               dirty.add(dst);
+            }
+         }
+      }
+   }
+
+   commands.clear();
+}
+
+int SpriteBatch::size()
+{
+   return commands.size();
 }
 
+SpriteBatch batch;
+
 SDL_Surface *load_image(std::string filename)
 {
    SDL_Surface* loadedImage = NULL;
@@ -65,13 +231,16 @@ class Dot
       void show();
 };
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -79,23 +248,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -104,28 +282,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -134,8 +323,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -361,7 +550,7 @@ void Dot::move(std::vector<SDL_Rect> &rects, Circle &circle)
 void Dot::show()
 {
    cout << "Dot::show: c.x = " << c.x << " c.y = " << c.y << "\n";
-   apply_surface(c.x - c.r, c.y - c.r, dot, screen);
+   batch.add(c.x - c.r, c.y - c.r, dot, NULL, 1);
 }
 
 
@@ -444,9 +633,78 @@ void Square::show()
    apply_surface(box.x, box.y, square, screen);
 }
 
+DirtyRects::DirtyRects()
+{
+   pixels = 0;
+   totalPixels = 0;
+   frames = 0;
+}
+
+void DirtyRects::add(SDL_Rect rect)
+{
+   if ((rect.w > 0) && (rect.h > 0))
+   {
+      drawn.push_back(rect);
+   }
+}
+
+void DirtyRects::restore(SDL_Surface* backdrop, SDL_Surface* destination)
+{
+   // put the background back wherever something was drawn last frame
+   for (size_t i = 0; i < previous.size(); i++)
+   {
+      SDL_Rect source = previous[i];
+      SDL_Rect offset = previous[i];
+      SDL_BlitSurface(backdrop, &source, destination, &offset);
+      update.push_back(previous[i]);
+   }
+   previous.clear();
+}
+
+void DirtyRects::present(SDL_Surface* destination)
+{
+   for (size_t i = 0; i < drawn.size(); i++)
+   {
+      update.push_back(drawn[i]);
+   }
+
+   pixels = 0;
+   for (size_t i = 0; i < update.size(); i++)
+   {
+      pixels += update[i].w * update[i].h;
+   }
+   totalPixels += pixels;
+   frames++;
+
+   if (update.empty() == false)
+   {
+      SDL_UpdateRects(destination, update.size(), &update[0]);
+   }
+
+   // what was drawn this frame is what has to be erased next frame
+   previous.swap(drawn);
+   drawn.clear();
+   update.clear();
+}
+
+int DirtyRects::get_pixels()
+{
+   return pixels;
+}
+
+// once at exit, a line a frame would flood the terminal
+void DirtyRects::report()
+{
+   if (frames > 0)
+   {
+      std::cout << "Pixels touched: " << totalPixels / frames << " a frame on average over " << frames
+                << " frames, out of " << SCREEN_WIDTH * SCREEN_HEIGHT << "\n";
+   }
+}
+
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -471,12 +729,21 @@ bool load_files()
       return 1;
    }
 
+   background = SDL_CreateRGBSurface(SDL_SWSURFACE, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, screen->format->Rmask, screen->format->Gmask, screen->format->Bmask, screen->format->Amask);
+   if (background == NULL)
+   {
+      return false;
+   }
+   SDL_FillRect(background, &background->clip_rect, SDL_MapRGB(background->format, 0xFF, 0xFF, 0xFF));
+
    return true;
 }
 
 void clean_up()
 {
+   dirty.report();
    SDL_FreeSurface(dot);;
+   SDL_FreeSurface(background);
    
    SDL_Quit();
 }
@@ -510,6 +777,14 @@ int main(int argc, char* args[])
    otherDot.y = 30;
    otherDot.r = DOT_WIDTH / 2;
 
+   // the wall never moves, so it is part of the background
+   SDL_FillRect(background, &box[0], SDL_MapRGB(background->format, 0x00, 0x00, 0x00));
+   SDL_BlitSurface(background, NULL, screen, NULL);
+   if (SDL_Flip(screen) == -1)
+   {
+      return 1;
+   }
+
    while(quit == false)
    {
       fps.start();
@@ -525,20 +800,19 @@ int main(int argc, char* args[])
 
       myDot.move(box, otherDot);
 
-      SDL_FillRect(screen, &screen->clip_rect, SDL_MapRGB(screen->format, 0xFF, 0xFF, 0xFF));
-      SDL_FillRect(screen, &box[0], SDL_MapRGB(screen->format, 0x00, 0x00, 0x00));
-      apply_surface(otherDot.x - otherDot.r, otherDot.y - otherDot.r, dot, screen);
+      dirty.restore(background, screen);
+      batch.add(otherDot.x - otherDot.r, otherDot.y - otherDot.r, dot);
 
       myDot.show();
 
-      if (SDL_Flip(screen) == -1)
-      {
-         return 1;
-      }
+      batch.draw(screen);
+
+      dirty.present(screen);
 
-      if (fps.get_ticks() < 1000 / FRAMES_PER_SECOND)
+      long long frameMicros = 1000000 / FRAMES_PER_SECOND;
+      if (fps.get_micros() < frameMicros)
       {
-         SDL_Delay((1000/FRAMES_PER_SECOND) - fps.get_ticks());
+         SDL_Delay((frameMicros - fps.get_micros() + 999) / 1000);
       }
    }
    clean_up();
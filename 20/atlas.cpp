@@ -0,0 +1,333 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_image.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+using std::cout;
+
+// usage: atlas atlas.txt atlas.bmp atlas_clips.h
+// Packs every sprite listed in the manifest into one image with a skyline
+// bottom-left packer and writes a header naming where each one ended up.
+// Image paths in the manifest are relative to where it is run from. Only
+// the header is checked in; atlas.bmp is made again from the manifest by
+// running this in the lesson's directory before the lesson is run.
+
+struct Sprite
+{
+   std::string name;
+   std::string file;
+   SDL_Rect source;
+   SDL_Rect packed;
+   int order;
+};
+
+// one segment of the skyline: the top of everything packed so far between x and x + w
+struct Skyline
+{
+   int x, y, w;
+};
+
+bool by_size(const Sprite &A, const Sprite &B)
+{
+   if (A.source.h != B.source.h)
+   {
+      return A.source.h > B.source.h;
+   }
+   if (A.source.w != B.source.w)
+   {
+      return A.source.w > B.source.w;
+   }
+   return A.order < B.order;
+}
+
+bool by_order(const Sprite &A, const Sprite &B)
+{
+   return A.order < B.order;
+}
+
+bool read_manifest(std::string filename, std::vector<Sprite> &sprites)
+{
+   std::ifstream manifest(filename.c_str());
+   if (manifest.is_open() == false)
+   {
+      return false;
+   }
+
+   std::string line;
+   while (std::getline(manifest, line))
+   {
+      if ((line.empty() == true) || (line[0] == '#'))
+      {
+         continue;
+      }
+
+      std::stringstream fields(line);
+      Sprite sprite;
+      int x = 0, y = 0, w = 0, h = 0;
+      fields >> sprite.name >> sprite.file;
+      if (!(fields >> x >> y >> w >> h))
+      {
+         w = 0;
+         h = 0;
+      }
+      sprite.source.x = x;
+      sprite.source.y = y;
+      sprite.source.w = w;
+      sprite.source.h = h;
+      sprite.order = sprites.size();
+      sprites.push_back(sprite);
+   }
+   return true;
+}
+
+// the lowest y a w wide sprite can sit at starting on segment i, or -1 if it runs off the edge
+int skyline_fit(std::vector<Skyline> &skyline, int i, int w, int width)
+{
+   if (skyline[i].x + w > width)
+   {
+      return -1;
+   }
+   int y = 0;
+   int left = w;
+   for (; left > 0; i++)
+   {
+      y = std::max(y, skyline[i].y);
+      left -= skyline[i].w;
+   }
+   return y;
+}
+
+void skyline_add(std::vector<Skyline> &skyline, size_t i, SDL_Rect &rect)
+{
+   Skyline top = { rect.x, rect.y + rect.h, rect.w };
+   skyline.insert(skyline.begin() + i, top);
+
+   // trim or drop the segments the new one now covers
+   for (size_t j = i + 1; j < skyline.size(); )
+   {
+      int overlap = top.x + top.w - skyline[j].x;
+      if (overlap <= 0)
+      {
+         break;
+      }
+      if (overlap >= skyline[j].w)
+      {
+         skyline.erase(skyline.begin() + j);
+         continue;
+      }
+      skyline[j].x += overlap;
+      skyline[j].w -= overlap;
+      break;
+   }
+
+   // merge neighbours at the same height
+   for (size_t j = 0; j + 1 < skyline.size(); )
+   {
+      if (skyline[j].y == skyline[j + 1].y)
+      {
+         skyline[j].w += skyline[j + 1].w;
+         skyline.erase(skyline.begin() + j + 1);
+      }
+      else
+      {
+         j++;
+      }
+   }
+}
+
+// returns the atlas height
+int pack(std::vector<Sprite> &sprites, int width)
+{
+   std::vector<Skyline> skyline;
+   Skyline floor = { 0, 0, width };
+   skyline.push_back(floor);
+   int height = 0;
+
+   for (size_t s = 0; s < sprites.size(); s++)
+   {
+      int w = sprites[s].source.w;
+      int h = sprites[s].source.h;
+      int best = -1, bestY = 0, bestW = 0;
+
+      for (size_t i = 0; i < skyline.size(); i++)
+      {
+         int y = skyline_fit(skyline, i, w, width);
+         if (y == -1)
+         {
+            continue;
+         }
+         if ((best == -1) || (y < bestY) || ((y == bestY) && (skyline[i].w < bestW)))
+         {
+            best = i;
+            bestY = y;
+            bestW = skyline[i].w;
+         }
+      }
+
+      sprites[s].packed.x = skyline[best].x;
+      sprites[s].packed.y = bestY;
+      sprites[s].packed.w = w;
+      sprites[s].packed.h = h;
+      skyline_add(skyline, best, sprites[s].packed);
+      height = std::max(height, bestY + h);
+   }
+   return height;
+}
+
+std::string constant_name(std::string name)
+{
+   std::string constant = "ATLAS_";
+   for (size_t i = 0; i < name.size(); i++)
+   {
+      char c = name[i];
+      if ((c >= 'a') && (c <= 'z'))
+      {
+         c = c - 'a' + 'A';
+      }
+      else if (!(((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'))))
+      {
+         c = '_';
+      }
+      constant += c;
+   }
+   return constant;
+}
+
+bool write_header(std::string filename, std::string image, std::vector<Sprite> &sprites)
+{
+   std::ofstream header(filename.c_str());
+   if (header.is_open() == false)
+   {
+      return false;
+   }
+
+   header << "// generated by atlas, do not edit\n";
+   header << "#ifndef ATLAS_CLIPS_H\n";
+   header << "#define ATLAS_CLIPS_H\n\n";
+   header << "#include \"SDL/SDL.h\"\n\n";
+   header << "const char ATLAS_IMAGE[] = \"" << image << "\";\n\n";
+   header << "enum AtlasClip\n{\n";
+   for (size_t i = 0; i < sprites.size(); i++)
+   {
+      header << "   " << constant_name(sprites[i].name) << ",\n";
+   }
+   header << "   ATLAS_CLIP_COUNT\n};\n\n";
+   header << "const SDL_Rect atlasClips[ATLAS_CLIP_COUNT] =\n{\n";
+   for (size_t i = 0; i < sprites.size(); i++)
+   {
+      SDL_Rect &r = sprites[i].packed;
+      header << "   { " << r.x << ", " << r.y << ", " << r.w << ", " << r.h << " }";
+      header << (i + 1 < sprites.size() ? "," : "") << " // " << sprites[i].name << "\n";
+   }
+   header << "};\n\n";
+   header << "#endif\n";
+   return header.good();
+}
+
+int main(int argc, char* args[])
+{
+   if (argc != 4)
+   {
+      cout << "usage: " << args[0] << " atlas.txt atlas.bmp atlas_clips.h\n";
+      return 1;
+   }
+
+   std::vector<Sprite> sprites;
+   if ((read_manifest(args[1], sprites) == false) || (sprites.empty() == true))
+   {
+      cout << args[1] << ": no sprites\n";
+      return 1;
+   }
+
+   if (SDL_Init(0) == -1)
+   {
+      return 1;
+   }
+
+   // decode each image once, however many sprites come out of it
+   std::map<std::string, SDL_Surface*> images;
+   for (size_t i = 0; i < sprites.size(); i++)
+   {
+      SDL_Surface *&image = images[sprites[i].file];
+      if (image == NULL)
+      {
+         image = IMG_Load(sprites[i].file.c_str());
+         if (image == NULL)
+         {
+            cout << sprites[i].file << ": " << IMG_GetError() << "\n";
+            return 1;
+         }
+      }
+      if (sprites[i].source.w == 0)
+      {
+         sprites[i].source.w = image->w;
+         sprites[i].source.h = image->h;
+      }
+   }
+
+   // every width from the widest sprite to all of them in a row is tried, and
+   // the one that wastes the least wins, the squarer on a tie, since software
+   // surfaces don't need a power of two and the atlas is held in memory whole
+   int widest = 0, row = 0;
+   for (size_t i = 0; i < sprites.size(); i++)
+   {
+      widest = std::max(widest, (int)sprites[i].source.w);
+      row += sprites[i].source.w;
+   }
+   std::stable_sort(sprites.begin(), sprites.end(), by_size);
+   int width = 0, height = 0;
+   for (int tryWidth = widest; tryWidth <= row; tryWidth++)
+   {
+      int tryHeight = pack(sprites, tryWidth);
+      long area = (long)tryWidth * tryHeight;
+      long best = (long)width * height;
+      if ((width == 0) || (area < best) ||
+          ((area == best) && (std::max(tryWidth, tryHeight) < std::max(width, height))))
+      {
+         width = tryWidth;
+         height = tryHeight;
+      }
+   }
+   pack(sprites, width);
+   std::stable_sort(sprites.begin(), sprites.end(), by_order);
+
+   SDL_Surface *atlas = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, 24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+   // the gaps get the same cyan load_image keys out
+   SDL_FillRect(atlas, NULL, SDL_MapRGB(atlas->format, 0, 0xFF, 0xFF));
+   for (size_t i = 0; i < sprites.size(); i++)
+   {
+      SDL_Surface *image = images[sprites[i].file];
+      SDL_SetAlpha(image, 0, SDL_ALPHA_OPAQUE);
+      SDL_Rect offset = sprites[i].packed;
+      SDL_BlitSurface(image, &sprites[i].source, atlas, &offset);
+   }
+
+   int result = 0;
+   if (SDL_SaveBMP(atlas, args[2]) == -1)
+   {
+      cout << args[2] << ": " << SDL_GetError() << "\n";
+      result = 1;
+   }
+   else if (write_header(args[3], args[2], sprites) == false)
+   {
+      cout << args[3] << ": could not write\n";
+      result = 1;
+   }
+   else
+   {
+      cout << sprites.size() << " sprites from " << images.size() << " images into " << width << "x" << height << "\n";
+   }
+
+   SDL_FreeSurface(atlas);
+   for (std::map<std::string, SDL_Surface*>::iterator i = images.begin(); i != images.end(); i++)
+   {
+      SDL_FreeSurface(i->second);
+   }
+   SDL_Quit();
+   return result;
+}
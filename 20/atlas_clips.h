@@ -0,0 +1,34 @@
+// generated by atlas, do not edit
+#ifndef ATLAS_CLIPS_H
+#define ATLAS_CLIPS_H
+
+#include "SDL/SDL.h"
+
+const char ATLAS_IMAGE[] = "atlas.bmp";
+
+enum AtlasClip
+{
+   ATLAS_FOO_RIGHT_0,
+   ATLAS_FOO_RIGHT_1,
+   ATLAS_FOO_RIGHT_2,
+   ATLAS_FOO_RIGHT_3,
+   ATLAS_FOO_LEFT_0,
+   ATLAS_FOO_LEFT_1,
+   ATLAS_FOO_LEFT_2,
+   ATLAS_FOO_LEFT_3,
+   ATLAS_CLIP_COUNT
+};
+
+const SDL_Rect atlasClips[ATLAS_CLIP_COUNT] =
+{
+   { 0, 0, 64, 205 }, // foo_right_0
+   { 64, 0, 64, 205 }, // foo_right_1
+   { 128, 0, 64, 205 }, // foo_right_2
+   { 192, 0, 64, 205 }, // foo_right_3
+   { 0, 205, 64, 205 }, // foo_left_0
+   { 64, 205, 64, 205 }, // foo_left_1
+   { 128, 205, 64, 205 }, // foo_left_2
+   { 192, 205, 64, 205 } // foo_left_3
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_image.h"
+#include "colorkey_blit.h"
+#include <string>
+#include <cstring>
+#include <iostream>
+
+using std::cout;
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+const int SCREEN_BPP = 32;
+const int BLITS = 20000;
+
+SDL_Surface *screen = NULL;
+SDL_Surface *target = NULL;
+// what SDL_BlitSurface drew, for colorkey_blit to be held against
+SDL_Surface *expected = NULL;
+
+SDL_Surface *load_image(std::string filename)
+{
+   SDL_Surface* loadedImage = NULL;
+   SDL_Surface* optimizedImage = NULL;
+   loadedImage = IMG_Load(filename.c_str());
+   if (loadedImage != NULL)
+   {
+      optimizedImage = SDL_DisplayFormat(loadedImage);
+      SDL_FreeSurface(loadedImage);
+      Uint32 colorkey = SDL_MapRGB(optimizedImage->format, 0, 0xFF, 0xFF);
+      SDL_SetColorKey(optimizedImage, SDL_SRCCOLORKEY, colorkey);
+   }
+   return optimizedImage;
+}
+
+// spreads the blits over the target so they don't all hit the same cache lines
+void blit_position(int i, SDL_Surface* source, SDL_Rect* offset)
+{
+   offset->x = (i * 37) % (SCREEN_WIDTH - source->w + 1);
+   offset->y = (i * 91) % (SCREEN_HEIGHT - source->h + 1);
+}
+
+void report(std::string name, SDL_Surface* source, Uint32 ms)
+{
+   double pixels = (double)BLITS * source->w * source->h;
+   cout << "   " << name << ": " << ms << " ms";
+   if (ms > 0)
+   {
+      cout << ", " << pixels / (ms * 1000.0) << " Mpixels/s";
+   }
+   cout << "\n";
+}
+
+bool same_pixels(SDL_Surface* a, SDL_Surface* b)
+{
+   SDL_LockSurface(a);
+   SDL_LockSurface(b);
+   bool same = true;
+   for (int y = 0; (same == true) && (y < a->h); y++)
+   {
+      same = memcmp((Uint8*)a->pixels + y * a->pitch, (Uint8*)b->pixels + y * b->pitch, a->w * 4) == 0;
+   }
+   SDL_UnlockSurface(b);
+   SDL_UnlockSurface(a);
+   return same;
+}
+
+// One blit both ways onto the same background: the pixels and the rect
+// written back into offset have to come out the same.
+bool check_blit(SDL_Surface* source, SDL_Rect* clip, int x, int y)
+{
+   Uint32 background = SDL_MapRGB(target->format, 0x40, 0x80, 0xC0);
+   SDL_FillRect(expected, NULL, background);
+   SDL_FillRect(target, NULL, background);
+
+   SDL_Rect sdlOffset = { (Sint16)x, (Sint16)y, 0, 0 };
+   SDL_Rect ourOffset = sdlOffset;
+   SDL_BlitSurface(source, clip, expected, &sdlOffset);
+   if (colorkey_blit(source, clip, target, &ourOffset) == false)
+   {
+      cout << "   colorkey_blit turned down a surface it should take\n";
+      return false;
+   }
+
+   if ((same_pixels(expected, target) == false) ||
+       (memcmp(&sdlOffset, &ourOffset, sizeof(SDL_Rect)) != 0))
+   {
+      cout << "   colorkey_blit at " << x << "," << y << (clip != NULL ? " with a clip" : "") << " DIFFERS from SDL_BlitSurface\n";
+      return false;
+   }
+   return true;
+}
+
+// the spread the timing uses, and every way a blit can be clipped
+bool check_blits(SDL_Surface* source)
+{
+   bool same = true;
+   SDL_Rect offset;
+   for (int i = 0; i < 64; i++)
+   {
+      blit_position(i, source, &offset);
+      same = check_blit(source, NULL, offset.x, offset.y) && same;
+   }
+
+   int w = source->w, h = source->h;
+   SDL_Rect inner = { (Sint16)(w / 4), (Sint16)(h / 4), (Uint16)(w / 2), (Uint16)(h / 2) };
+   SDL_Rect outside = { (Sint16)(-w / 4), (Sint16)(-h / 4), (Uint16)w, (Uint16)h };
+   same = check_blit(source, NULL, -w / 2, -h / 2) && same;
+   same = check_blit(source, NULL, SCREEN_WIDTH - w / 2, SCREEN_HEIGHT - h / 2) && same;
+   same = check_blit(source, NULL, SCREEN_WIDTH, 0) && same;
+   same = check_blit(source, &inner, 10, 10) && same;
+   same = check_blit(source, &outside, 10, 10) && same;
+
+   // and against a destination clip rect
+   SDL_Rect window = { 100, 100, (Uint16)(w / 2 + 1), (Uint16)(h / 2 + 1) };
+   SDL_SetClipRect(expected, &window);
+   SDL_SetClipRect(target, &window);
+   same = check_blit(source, NULL, 100 - w / 3, 100 - h / 3) && same;
+   SDL_SetClipRect(expected, NULL);
+   SDL_SetClipRect(target, NULL);
+   return same;
+}
+
+bool bench(std::string filename)
+{
+   SDL_Surface *source = load_image(filename);
+   if (source == NULL)
+   {
+      cout << filename << ": could not load\n";
+      return false;
+   }
+
+   cout << filename << " (" << source->w << "x" << source->h << ")\n";
+   bool same = check_blits(source);
+   cout << "   colorkey_blit " << (same ? "matches" : "does not match") << " SDL_BlitSurface\n";
+   Uint32 key = source->format->colorkey;
+   SDL_Rect offset;
+
+   Uint32 start = SDL_GetTicks();
+   for (int i = 0; i < BLITS; i++)
+   {
+      blit_position(i, source, &offset);
+      SDL_BlitSurface(source, NULL, target, &offset);
+   }
+   report("SDL_BlitSurface", source, SDL_GetTicks() - start);
+
+   start = SDL_GetTicks();
+   for (int i = 0; i < BLITS; i++)
+   {
+      blit_position(i, source, &offset);
+      colorkey_blit(source, NULL, target, &offset);
+   }
+   report("colorkey_blit", source, SDL_GetTicks() - start);
+
+   SDL_SetColorKey(source, SDL_SRCCOLORKEY | SDL_RLEACCEL, key);
+   // the first blit does the RLE encoding, keep it out of the timing
+   offset.x = 0;
+   offset.y = 0;
+   SDL_BlitSurface(source, NULL, target, &offset);
+
+   start = SDL_GetTicks();
+   for (int i = 0; i < BLITS; i++)
+   {
+      blit_position(i, source, &offset);
+      SDL_BlitSurface(source, NULL, target, &offset);
+   }
+   report("SDL_BlitSurface + SDL_RLEACCEL", source, SDL_GetTicks() - start);
+
+   SDL_FreeSurface(source);
+   return same;
+}
+
+int main(int argc, char* args[])
+{
+   // no window is needed, only a display format to convert to
+   SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return 1;
+   }
+
+   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+   if (screen == NULL)
+   {
+      return 1;
+   }
+
+   target = SDL_DisplayFormat(screen);
+   expected = SDL_DisplayFormat(screen);
+   if ((target == NULL) || (expected == NULL))
+   {
+      return 1;
+   }
+
+   bool same = bench("../16/dot.bmp");
+   same = bench("foo.png") && same;
+   same = bench("../09/button.png") && same;
+
+   SDL_FreeSurface(expected);
+   SDL_FreeSurface(target);
+   SDL_Quit();
+   return same ? 0 : 1;
+}
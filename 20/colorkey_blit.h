@@ -0,0 +1,209 @@
+#ifndef COLORKEY_BLIT_H
+#define COLORKEY_BLIT_H
+
+#include "SDL/SDL.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLORKEY_BLIT_X86
+#include <immintrin.h>
+#endif
+
+// copies one row of 32bpp pixels, leaving dst alone wherever src matches the key
+typedef void (*ColorkeyRow)(const Uint32 *src, Uint32 *dst, int w, Uint32 key, Uint32 keymask);
+
+static void colorkey_row_scalar(const Uint32 *src, Uint32 *dst, int w, Uint32 key, Uint32 keymask)
+{
+   for (int i = 0; i < w; i++)
+   {
+      if ((src[i] & keymask) != key)
+      {
+         dst[i] = src[i];
+      }
+   }
+}
+
+#ifdef COLORKEY_BLIT_X86
+__attribute__((target("sse2")))
+static void colorkey_row_sse2(const Uint32 *src, Uint32 *dst, int w, Uint32 key, Uint32 keymask)
+{
+   __m128i k = _mm_set1_epi32(key);
+   __m128i m = _mm_set1_epi32(keymask);
+   int i = 0;
+   for (; i + 4 <= w; i += 4)
+   {
+      __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+      __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+      // all ones where the pixel is transparent
+      __m128i hole = _mm_cmpeq_epi32(_mm_and_si128(s, m), k);
+      __m128i out = _mm_or_si128(_mm_and_si128(hole, d), _mm_andnot_si128(hole, s));
+      _mm_storeu_si128((__m128i*)(dst + i), out);
+   }
+   colorkey_row_scalar(src + i, dst + i, w - i, key, keymask);
+}
+
+__attribute__((target("avx2")))
+static void colorkey_row_avx2(const Uint32 *src, Uint32 *dst, int w, Uint32 key, Uint32 keymask)
+{
+   __m256i k = _mm256_set1_epi32(key);
+   __m256i m = _mm256_set1_epi32(keymask);
+   int i = 0;
+   for (; i + 8 <= w; i += 8)
+   {
+      __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+      __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+      __m256i hole = _mm256_cmpeq_epi32(_mm256_and_si256(s, m), k);
+      _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(s, d, hole));
+   }
+   colorkey_row_sse2(src + i, dst + i, w - i, key, keymask);
+}
+#endif
+
+static ColorkeyRow colorkey_row_select()
+{
+#ifdef COLORKEY_BLIT_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+   {
+      return colorkey_row_avx2;
+   }
+   if (__builtin_cpu_supports("sse2"))
+   {
+      return colorkey_row_sse2;
+   }
+#endif
+   return colorkey_row_scalar;
+}
+
+static ColorkeyRow colorkey_row = colorkey_row_select();
+
+// Blits a colorkeyed 32bpp surface onto a 32bpp surface of the same format.
+// Clips like SDL_BlitSurface and writes the drawn area back into offset.
+// Returns false without drawing when the surfaces need SDL's own blitter
+// (other depths, RLE or per-surface alpha), so the caller can fall back.
+static bool colorkey_blit(SDL_Surface* source, const SDL_Rect* clip, SDL_Surface* destination, SDL_Rect* offset)
+{
+   SDL_PixelFormat *sf = source->format;
+   SDL_PixelFormat *df = destination->format;
+
+   if ((sf->BytesPerPixel != 4) || (df->BytesPerPixel != 4))
+   {
+      return false;
+   }
+   if ((source->flags & (SDL_SRCCOLORKEY | SDL_RLEACCEL | SDL_SRCALPHA)) != SDL_SRCCOLORKEY)
+   {
+      return false;
+   }
+   if ((sf->Rmask != df->Rmask) || (sf->Gmask != df->Gmask) || (sf->Bmask != df->Bmask))
+   {
+      return false;
+   }
+
+   int sx = 0, sy = 0;
+   int w = source->w, h = source->h;
+   if (clip != NULL)
+   {
+      sx = clip->x;
+      sy = clip->y;
+      w = clip->w;
+      h = clip->h;
+   }
+   int dx = offset->x, dy = offset->y;
+
+   if (sx < 0)
+   {
+      w += sx;
+      dx -= sx;
+      sx = 0;
+   }
+   if (sy < 0)
+   {
+      h += sy;
+      dy -= sy;
+      sy = 0;
+   }
+   if (sx + w > source->w)
+   {
+      w = source->w - sx;
+   }
+   if (sy + h > source->h)
+   {
+      h = source->h - sy;
+   }
+
+   SDL_Rect &c = destination->clip_rect;
+   if (dx < c.x)
+   {
+      sx += c.x - dx;
+      w -= c.x - dx;
+      dx = c.x;
+   }
+   if (dy < c.y)
+   {
+      sy += c.y - dy;
+      h -= c.y - dy;
+      dy = c.y;
+   }
+   if (dx + w > c.x + c.w)
+   {
+      w = c.x + c.w - dx;
+   }
+   if (dy + h > c.y + c.h)
+   {
+      h = c.y + c.h - dy;
+   }
+
+   if ((w <= 0) || (h <= 0))
+   {
+      offset->w = 0;
+      offset->h = 0;
+      return true;
+   }
+
+   // a surface's pixels can't be touched unlocked, the source's no more than the destination's
+   if (SDL_MUSTLOCK(source))
+   {
+      if (SDL_LockSurface(source) == -1)
+      {
+         return false;
+      }
+   }
+   if (SDL_MUSTLOCK(destination))
+   {
+      if (SDL_LockSurface(destination) == -1)
+      {
+         if (SDL_MUSTLOCK(source))
+         {
+            SDL_UnlockSurface(source);
+         }
+         return false;
+      }
+   }
+
+   Uint32 keymask = ~sf->Amask;
+   Uint32 key = sf->colorkey & keymask;
+   const Uint8 *srcRow = (const Uint8*)source->pixels + sy * source->pitch + sx * 4;
+   Uint8 *dstRow = (Uint8*)destination->pixels + dy * destination->pitch + dx * 4;
+   for (int row = 0; row < h; row++)
+   {
+      colorkey_row((const Uint32*)srcRow, (Uint32*)dstRow, w, key, keymask);
+      srcRow += source->pitch;
+      dstRow += destination->pitch;
+   }
+
+   if (SDL_MUSTLOCK(destination))
+   {
+      SDL_UnlockSurface(destination);
+   }
+   if (SDL_MUSTLOCK(source))
+   {
+      SDL_UnlockSurface(source);
+   }
+
+   offset->x = dx;
+   offset->y = dy;
+   offset->w = w;
+   offset->h = h;
+   return true;
+}
+
+#endif
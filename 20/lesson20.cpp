@@ -1,7 +1,11 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
+#include "colorkey_blit.h"
+#include "atlas_clips.h"
 #include <string>
 #include <iostream>
+#include <vector>
+#include <time.h>
 
 using std::cout;
 
@@ -16,18 +20,45 @@ const int FOO_LEFT = 1;
 
 SDL_Surface *foo = NULL;
 SDL_Surface *screen = NULL;
-
-SDL_Rect clipsRight[4];
-SDL_Rect clipsLeft[4];
+SDL_Surface *background = NULL;
 
 SDL_Event event;
 
-void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
+class DirtyRects
+{
+   private:
+      std::vector<SDL_Rect> drawn;
+      std::vector<SDL_Rect> previous;
+      std::vector<SDL_Rect> update;
+      int pixels;
+      long long totalPixels;
+      int frames;
+   public:
+      DirtyRects();
+      void add(SDL_Rect rect);
+      void restore(SDL_Surface* backdrop, SDL_Surface* destination);
+      void present(SDL_Surface* destination);
+      int get_pixels();
+      void report();
+};
+
+DirtyRects dirty;
+
+void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, const SDL_Rect* clip = NULL)
 {
    SDL_Rect offset;
    offset.x = x;
    offset.y = y;
-   SDL_BlitSurface(source, clip, destination, &offset);
+   if (colorkey_blit(source, clip, destination, &offset) == false)
+   {
+      // SDL 1.2 only reads the source rect, it just isn't declared const
+      SDL_BlitSurface(source, const_cast<SDL_Rect*>(clip), destination, &offset);
+   }
+   // either blit leaves the clipped bounds it actually wrote in offset
+   if (destination == screen)
+   {
+      dirty.add(offset);
+   }
 }
 
 SDL_Surface *load_image(std::string filename)
@@ -59,49 +90,6 @@ class Foo
       void show();
 };
 
-void set_clips()
-{
-   clipsRight[0].x = 0;
-   clipsRight[0].y = 0;
-   clipsRight[0].w = FOO_WIDTH;
-   clipsRight[0].h = FOO_HEIGHT;
-   
-   clipsRight[1].x = FOO_WIDTH;
-   clipsRight[1].y = 0;
-   clipsRight[1].w = FOO_WIDTH;
-   clipsRight[1].h = FOO_HEIGHT;
-
-   clipsRight[2].x = FOO_WIDTH * 2;
-   clipsRight[2].y = 0;
-   clipsRight[2].w = FOO_WIDTH;
-   clipsRight[2].h = FOO_HEIGHT;
-
-   clipsRight[3].x = FOO_WIDTH * 3;
-   clipsRight[3].y = 0;
-   clipsRight[3].w = FOO_WIDTH;
-   clipsRight[3].h = FOO_HEIGHT;
-
-   clipsLeft[0].x = 0;
-   clipsLeft[0].y = FOO_HEIGHT;
-   clipsLeft[0].w = FOO_WIDTH;
-   clipsLeft[0].h = FOO_HEIGHT;
-
-   clipsLeft[1].x = FOO_WIDTH;
-   clipsLeft[1].y = FOO_HEIGHT;
-   clipsLeft[1].w = FOO_WIDTH;
-   clipsLeft[1].h = FOO_HEIGHT;
-
-   clipsLeft[2].x = FOO_WIDTH * 2;
-   clipsLeft[2].y = FOO_HEIGHT;
-   clipsLeft[2].w = FOO_WIDTH;
-   clipsLeft[2].h = FOO_HEIGHT;
-
-   clipsLeft[3].x = FOO_WIDTH * 3;
-   clipsLeft[3].y = FOO_HEIGHT;
-   clipsLeft[3].w = FOO_WIDTH;
-   clipsLeft[3].h = FOO_HEIGHT;
-}
-
 Foo::Foo()
 {
    offSet = 0;
@@ -142,22 +130,25 @@ void Foo::show()
    }
    if (status == FOO_RIGHT)
    {
-      apply_surface(offSet, SCREEN_HEIGHT - FOO_HEIGHT, foo, screen, &clipsRight[frame]);
+      apply_surface(offSet, SCREEN_HEIGHT - FOO_HEIGHT, foo, screen, &atlasClips[ATLAS_FOO_RIGHT_0 + frame]);
    }
    else if (status == FOO_LEFT)
    {
-      apply_surface(offSet, SCREEN_HEIGHT - FOO_HEIGHT, foo, screen, &clipsLeft[frame]);
+      apply_surface(offSet, SCREEN_HEIGHT - FOO_HEIGHT, foo, screen, &atlasClips[ATLAS_FOO_LEFT_0 + frame]);
    }
 }
 
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -165,23 +156,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -190,28 +190,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -220,8 +231,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -269,9 +280,78 @@ void Foo::handle_events()
    }
 }
 
+DirtyRects::DirtyRects()
+{
+   pixels = 0;
+   totalPixels = 0;
+   frames = 0;
+}
+
+void DirtyRects::add(SDL_Rect rect)
+{
+   if ((rect.w > 0) && (rect.h > 0))
+   {
+      drawn.push_back(rect);
+   }
+}
+
+void DirtyRects::restore(SDL_Surface* backdrop, SDL_Surface* destination)
+{
+   // put the background back wherever something was drawn last frame
+   for (size_t i = 0; i < previous.size(); i++)
+   {
+      SDL_Rect source = previous[i];
+      SDL_Rect offset = previous[i];
+      SDL_BlitSurface(backdrop, &source, destination, &offset);
+      update.push_back(previous[i]);
+   }
+   previous.clear();
+}
+
+void DirtyRects::present(SDL_Surface* destination)
+{
+   for (size_t i = 0; i < drawn.size(); i++)
+   {
+      update.push_back(drawn[i]);
+   }
+
+   pixels = 0;
+   for (size_t i = 0; i < update.size(); i++)
+   {
+      pixels += update[i].w * update[i].h;
+   }
+   totalPixels += pixels;
+   frames++;
+
+   if (update.empty() == false)
+   {
+      SDL_UpdateRects(destination, update.size(), &update[0]);
+   }
+
+   // what was drawn this frame is what has to be erased next frame
+   previous.swap(drawn);
+   drawn.clear();
+   update.clear();
+}
+
+int DirtyRects::get_pixels()
+{
+   return pixels;
+}
+
+// once at exit, a line a frame would flood the terminal
+void DirtyRects::report()
+{
+   if (frames > 0)
+   {
+      std::cout << "Pixels touched: " << totalPixels / frames << " a frame on average over " << frames
+                << " frames, out of " << SCREEN_WIDTH * SCREEN_HEIGHT << "\n";
+   }
+}
+
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -290,18 +370,28 @@ bool init()
 
 bool load_files()
 {
-   foo = load_image("foo.png");
+   // foo's frames from atlas.txt, packed by "atlas atlas.txt atlas.bmp atlas_clips.h"
+   foo = load_image(ATLAS_IMAGE);
    if (foo == NULL)
    {
       return 1;
    }
 
+   background = SDL_CreateRGBSurface(SDL_SWSURFACE, SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, screen->format->Rmask, screen->format->Gmask, screen->format->Bmask, screen->format->Amask);
+   if (background == NULL)
+   {
+      return false;
+   }
+   SDL_FillRect(background, &background->clip_rect, SDL_MapRGB(background->format, 0xFF, 0xFF, 0xFF));
+
    return true;
 }
 
 void clean_up()
 {
+   dirty.report();
    SDL_FreeSurface(foo);;
+   SDL_FreeSurface(background);
    
    SDL_Quit();
 }
@@ -320,10 +410,15 @@ int main(int argc, char* args[])
       return 1;
    }
     
-   set_clips();
    Timer fps;
    Foo walk;
 
+   SDL_BlitSurface(background, NULL, screen, NULL);
+   if (SDL_Flip(screen) == -1)
+   {
+      return 1;
+   }
+
    while(quit == false)
    {
       fps.start();
@@ -339,18 +434,16 @@ int main(int argc, char* args[])
 
       walk.move();
 
-      SDL_FillRect(screen, &screen->clip_rect, SDL_MapRGB(screen->format, 0xFF, 0xFF, 0xFF));
+      dirty.restore(background, screen);
 
       walk.show();
 
-      if (SDL_Flip(screen) == -1)
-      {
-         return 1;
-      }
+      dirty.present(screen);
 
-      if (fps.get_ticks() < 1000 / FRAMES_PER_SECOND)
+      long long frameMicros = 1000000 / FRAMES_PER_SECOND;
+      if (fps.get_micros() < frameMicros)
       {
-         SDL_Delay((1000/FRAMES_PER_SECOND) - fps.get_ticks());
+         SDL_Delay((frameMicros - fps.get_micros() + 999) / 1000);
       }
    }
    clean_up();
@@ -0,0 +1,66 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_image.h"
+#include "cooked_image.h"
+#include <string>
+#include <iostream>
+
+using std::cout;
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+const int SCREEN_BPP = 32;
+
+// usage: cook image.png image.raw [more pairs...]
+// Decodes each image once and writes it in the display format the lessons
+// convert to, with the same cyan colorkey load_image sets.
+int main(int argc, char* args[])
+{
+   if ((argc < 3) || (argc % 2 == 0))
+   {
+      cout << "usage: " << args[0] << " input output [input output ...]\n";
+      return 1;
+   }
+
+   SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return 1;
+   }
+
+   if (SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE) == NULL)
+   {
+      return 1;
+   }
+
+   int failed = 0;
+   for (int i = 1; i + 1 < argc; i += 2)
+   {
+      SDL_Surface *loadedImage = IMG_Load(args[i]);
+      if (loadedImage == NULL)
+      {
+         cout << args[i] << ": " << IMG_GetError() << "\n";
+         failed++;
+         continue;
+      }
+
+      SDL_Surface *optimizedImage = SDL_DisplayFormat(loadedImage);
+      SDL_FreeSurface(loadedImage);
+      Uint32 colorkey = SDL_MapRGB(optimizedImage->format, 0, 0xFF, 0xFF);
+      SDL_SetColorKey(optimizedImage, SDL_SRCCOLORKEY, colorkey);
+
+      if (save_cooked(optimizedImage, args[i + 1]) == false)
+      {
+         cout << args[i + 1] << ": could not write\n";
+         failed++;
+      }
+      else
+      {
+         cout << args[i] << " -> " << args[i + 1] << " (" << optimizedImage->w << "x" << optimizedImage->h << ")\n";
+      }
+      SDL_FreeSurface(optimizedImage);
+   }
+
+   SDL_Quit();
+   return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#ifndef COOKED_IMAGE_H
+#define COOKED_IMAGE_H
+
+#include "SDL/SDL.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// A cooked image is a surface already converted to the display format,
+// written out as a header followed by the raw rows. Loading one is an mmap
+// and a SDL_CreateRGBSurfaceFrom, with no decode and no conversion.
+const char COOKED_MAGIC[4] = { 'C', 'O', 'O', 'K' };
+const int COOKED_VERSION = 1;
+// the pixels start here so rows stay 16 byte aligned in the mapping
+const int COOKED_PIXELS = 64;
+
+struct CookedHeader
+{
+   char magic[4];
+   Uint32 version;
+   Uint32 width, height, pitch;
+   Uint32 Rmask, Gmask, Bmask, Amask;
+   Uint32 colorkey;
+   Uint32 hasColorkey;
+};
+
+struct CookedMapping
+{
+   SDL_Surface *surface;
+   void *data;
+   size_t size;
+};
+
+std::vector<CookedMapping> cookedMappings;
+
+bool save_cooked(SDL_Surface* surface, std::string filename)
+{
+   if (surface->format->BytesPerPixel != 4)
+   {
+      return false;
+   }
+
+   CookedHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, COOKED_MAGIC, 4);
+   header.version = COOKED_VERSION;
+   header.width = surface->w;
+   header.height = surface->h;
+   header.pitch = surface->w * 4;
+   header.Rmask = surface->format->Rmask;
+   header.Gmask = surface->format->Gmask;
+   header.Bmask = surface->format->Bmask;
+   header.Amask = surface->format->Amask;
+   header.colorkey = surface->format->colorkey;
+   header.hasColorkey = (surface->flags & SDL_SRCCOLORKEY) ? 1 : 0;
+
+   FILE *file = fopen(filename.c_str(), "wb");
+   if (file == NULL)
+   {
+      return false;
+   }
+
+   char padding[COOKED_PIXELS];
+   memset(padding, 0, sizeof(padding));
+   bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+   ok = ok && (fwrite(padding, COOKED_PIXELS - sizeof(header), 1, file) == 1);
+
+   SDL_LockSurface(surface);
+   for (int y = 0; (y < surface->h) && (ok == true); y++)
+   {
+      ok = fwrite((Uint8*)surface->pixels + y * surface->pitch, header.pitch, 1, file) == 1;
+   }
+   SDL_UnlockSurface(surface);
+
+   if (fclose(file) != 0)
+   {
+      ok = false;
+   }
+   return ok;
+}
+
+// Returns NULL if the file is missing or not a cooked image, so callers can
+// fall back to decoding the original. If the display format differs from the
+// one the image was cooked for, the mapping is converted once and dropped.
+SDL_Surface *load_cooked(std::string filename)
+{
+   int fd = open(filename.c_str(), O_RDONLY);
+   if (fd == -1)
+   {
+      return NULL;
+   }
+
+   struct stat info;
+   if ((fstat(fd, &info) == -1) || (info.st_size < COOKED_PIXELS))
+   {
+      close(fd);
+      return NULL;
+   }
+
+   size_t size = info.st_size;
+   // private and writable, so anything SDL scribbles on stays out of the file
+   void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (data == MAP_FAILED)
+   {
+      return NULL;
+   }
+
+   CookedHeader header;
+   memcpy(&header, data, sizeof(header));
+   if ((memcmp(header.magic, COOKED_MAGIC, 4) != 0) || (header.version != COOKED_VERSION) ||
+       (header.pitch < header.width * 4) || (COOKED_PIXELS + (size_t)header.pitch * header.height > size))
+   {
+      munmap(data, size);
+      return NULL;
+   }
+
+   SDL_Surface *surface = SDL_CreateRGBSurfaceFrom((Uint8*)data + COOKED_PIXELS, header.width, header.height, 32, header.pitch,
+                                                   header.Rmask, header.Gmask, header.Bmask, header.Amask);
+   if (surface == NULL)
+   {
+      munmap(data, size);
+      return NULL;
+   }
+
+   if (header.hasColorkey != 0)
+   {
+      SDL_SetColorKey(surface, SDL_SRCCOLORKEY, header.colorkey);
+   }
+
+   SDL_PixelFormat *display = SDL_GetVideoSurface()->format;
+   if ((display->BytesPerPixel != 4) || (display->Rmask != header.Rmask) || (display->Gmask != header.Gmask) ||
+       (display->Bmask != header.Bmask))
+   {
+      SDL_Surface *converted = SDL_DisplayFormat(surface);
+      SDL_FreeSurface(surface);
+      munmap(data, size);
+      return converted;
+   }
+
+   CookedMapping mapping;
+   mapping.surface = surface;
+   mapping.data = data;
+   mapping.size = size;
+   cookedMappings.push_back(mapping);
+
+   return surface;
+}
+
+// frees a surface from load_cooked, or any ordinary surface
+void free_cooked(SDL_Surface* surface)
+{
+   SDL_FreeSurface(surface);
+   for (size_t i = 0; i < cookedMappings.size(); i++)
+   {
+      if (cookedMappings[i].surface == surface)
+      {
+         munmap(cookedMappings[i].data, cookedMappings[i].size);
+         cookedMappings.erase(cookedMappings.begin() + i);
+         return;
+      }
+   }
+}
+
+#endif
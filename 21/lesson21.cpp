@@ -1,7 +1,19 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
+#include "band_compositor.h"
+#include "cooked_image.h"
+#include "tile_streamer.h"
 #include <string>
+#include <cstring>
 #include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <time.h>
 
 using std::cout;
 
@@ -16,12 +28,23 @@ const int DOT_HEIGHT = 20;
 const int LEVEL_WIDTH = 1280;
 const int LEVEL_HEIGHT = 960;
 
+const int TILE_SIZE = 256;
+
 SDL_Surface *dot = NULL;
 SDL_Surface *background = NULL;
 SDL_Surface *screen = NULL;
+BandCompositor *compositor = NULL;
+TileStreamer *streamer = NULL;
 
 SDL_Event event;
 
+// run this many frames offscreen as fast as possible, 0 for a normal window
+int headlessFrames = 0;
+
+// simulate on a separate thread and draw on the main one, which in SDL 1.2
+// has to be the thread that set the video mode and pumps the events
+bool threaded = false;
+
 SDL_Rect camera = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
 
 void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
@@ -47,13 +70,16 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -61,23 +87,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -86,28 +121,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -116,8 +162,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -138,10 +184,12 @@ class Dot
       int xVel, yVel;
    public:
       Dot();
-      void handle_input();
+      void handle_input(const SDL_Event &input);
       void move();
       void show();
       void set_camera();
+      int get_x();
+      int get_y();
 };
 
 Dot::Dot() 
@@ -152,11 +200,11 @@ Dot::Dot()
    yVel = 0;
 }
 
-void Dot::handle_input() 
+void Dot::handle_input(const SDL_Event &input) 
 {
-   if (event.type == SDL_KEYDOWN)
+   if (input.type == SDL_KEYDOWN)
    {
-      switch(event.key.keysym.sym)
+      switch(input.key.keysym.sym)
       {
          case SDLK_UP:
             yVel -= DOT_HEIGHT / 2;
@@ -173,9 +221,9 @@ void Dot::handle_input()
          default: break;
       }
    }
-   else if (event.type == SDL_KEYUP)
+   else if (input.type == SDL_KEYUP)
    {
-      switch(event.key.keysym.sym)
+      switch(input.key.keysym.sym)
       {
          case SDLK_UP:
             yVel += DOT_HEIGHT / 2;
@@ -237,9 +285,232 @@ void Dot::set_camera()
    }
 }
 
+class FrameStats
+{
+   private:
+      std::vector<double> times;
+   public:
+      void add(double ms);
+      void report();
+};
+
+void FrameStats::add(double ms)
+{
+   times.push_back(ms);
+}
+
+void FrameStats::report()
+{
+   if (times.empty() == true)
+   {
+      return;
+   }
+
+   std::vector<double> sorted = times;
+   std::sort(sorted.begin(), sorted.end());
+
+   double total = 0;
+   for (size_t i = 0; i < sorted.size(); i++)
+   {
+      total += sorted[i];
+   }
+
+   cout << "frames: " << sorted.size() << "\n";
+   cout << "total: " << total << " ms\n";
+   cout << "min: " << sorted.front() << " ms\n";
+   cout << "avg: " << total / sorted.size() << " ms\n";
+   cout << "median: " << sorted[sorted.size() / 2] << " ms\n";
+   cout << "p99: " << sorted[(sorted.size() * 99) / 100] << " ms\n";
+   cout << "max: " << sorted.back() << " ms\n";
+   if (total > 0)
+   {
+      cout << "fps: " << sorted.size() * 1000.0 / total << "\n";
+   }
+}
+
+// FNV-1a over the visible pixels, so two runs can be compared frame by frame
+Uint32 hash_surface(SDL_Surface* surface)
+{
+   Uint32 hash = 2166136261u;
+   int rowBytes = surface->w * surface->format->BytesPerPixel;
+
+   SDL_LockSurface(surface);
+   for (int y = 0; y < surface->h; y++)
+   {
+      Uint8 *row = (Uint8*)surface->pixels + y * surface->pitch;
+      for (int i = 0; i < rowBytes; i++)
+      {
+         hash = (hash ^ row[i]) * 16777619u;
+      }
+   }
+   SDL_UnlockSurface(surface);
+
+   return hash;
+}
+
+int Dot::get_x()
+{
+   return x;
+}
+
+int Dot::get_y()
+{
+   return y;
+}
+
+SDL_Surface *load_bg_tile(int column, int row, void *data)
+{
+   std::stringstream name;
+   name << "bg_tiles/bg_" << column << "_" << row << ".raw";
+   return load_cooked(name.str());
+}
+
+void show_background(SDL_Rect view)
+{
+   if (streamer != NULL)
+   {
+      streamer->update(view);
+      streamer->draw(view, screen);
+   }
+   else
+   {
+      compositor->blit(0, 0, background, screen, &view);
+   }
+}
+
+// sleeps out what is left of the frame fps was started at, to the next
+// whole millisecond since that is all SDL_Delay takes
+void cap_frame(Timer &fps)
+{
+   long long frameMicros = 1000000 / FRAMES_PER_SECOND;
+   if (fps.get_micros() < frameMicros)
+   {
+      SDL_Delay((frameMicros - fps.get_micros() + 999) / 1000);
+   }
+}
+
+// everything the renderer needs to draw one frame
+struct Snapshot
+{
+   int dotX, dotY;
+   SDL_Rect camera;
+};
+
+// Single writer, single reader. The writer fills its own buffer and swaps
+// it with the shared middle one; the reader swaps the middle one for its
+// own once the fresh bit says something new was published. The writer
+// never waits, and the reader sleeps on a semaphore that is posted each
+// time the middle buffer goes from stale to fresh, then always gets the
+// newest whole snapshot.
+class TripleBuffer
+{
+   private:
+      static const int FRESH = 4;
+      Snapshot buffers[3];
+      std::atomic<int> middle;
+      int writing;
+      int reading;
+      SDL_sem *ready;
+   public:
+      TripleBuffer();
+      ~TripleBuffer();
+      Snapshot &write_buffer();
+      void publish();
+      void acquire();
+      const Snapshot &read_buffer();
+};
+
+TripleBuffer::TripleBuffer()
+{
+   writing = 0;
+   middle = 1;
+   reading = 2;
+   ready = SDL_CreateSemaphore(0);
+}
+
+TripleBuffer::~TripleBuffer()
+{
+   SDL_DestroySemaphore(ready);
+}
+
+Snapshot &TripleBuffer::write_buffer()
+{
+   return buffers[writing];
+}
+
+void TripleBuffer::publish()
+{
+   int old = middle.exchange(writing | FRESH, std::memory_order_acq_rel);
+   writing = old & ~FRESH;
+   // a snapshot the reader hasn't taken yet already has its post
+   if ((old & FRESH) == 0)
+   {
+      SDL_SemPost(ready);
+   }
+}
+
+// blocks until there is a snapshot newer than the last one read
+void TripleBuffer::acquire()
+{
+   SDL_SemWait(ready);
+   reading = middle.exchange(reading, std::memory_order_acq_rel) & ~FRESH;
+}
+
+const Snapshot &TripleBuffer::read_buffer()
+{
+   return buffers[reading];
+}
+
+TripleBuffer snapshots;
+std::atomic<bool> simulating(false);
+
+// events the main thread pumped, waiting for the simulation to take them
+std::vector<SDL_Event> pendingInput;
+SDL_mutex *inputLock = NULL;
+
+// moves the dot at the lesson's frame rate and publishes where it and the
+// camera are; the main thread draws whatever was published last
+int simulate_thread(void *data)
+{
+   Dot *myDot = (Dot*)data;
+   Timer fps;
+   std::vector<SDL_Event> events;
+   while (simulating.load() == true)
+   {
+      fps.start();
+
+      SDL_mutexP(inputLock);
+      events.swap(pendingInput);
+      SDL_mutexV(inputLock);
+      for (size_t i = 0; i < events.size(); i++)
+      {
+         myDot->handle_input(events[i]);
+      }
+      events.clear();
+
+      myDot->move();
+      myDot->set_camera();
+
+      Snapshot &snap = snapshots.write_buffer();
+      snap.dotX = myDot->get_x();
+      snap.dotY = myDot->get_y();
+      snap.camera = camera;
+      snapshots.publish();
+
+      cap_frame(fps);
+   }
+   return 0;
+}
+
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (headlessFrames > 0)
+   {
+      // the dummy driver gives us an in-memory screen and no window
+      SDL_putenv("SDL_VIDEODRIVER=dummy");
+   }
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -263,7 +534,20 @@ bool load_files()
    {
       return false;
    }
-   background = load_image("bg.png");
+   // with tiles from "tile bg.png 256 bg_tiles/bg" only the part of the
+   // level around the camera is ever resident
+   if (access("bg_tiles/bg_0_0.raw", R_OK) == 0)
+   {
+      streamer = new TileStreamer(LEVEL_WIDTH, LEVEL_HEIGHT, TILE_SIZE, TILE_SIZE / 2, 32, load_bg_tile, free_cooked, NULL);
+      return true;
+   }
+
+   // bg.raw comes from "cook bg.png bg.raw"; decode the png if it isn't there
+   background = load_cooked("bg.raw");
+   if (background == NULL)
+   {
+      background = load_image("bg.png");
+   }
    if (background == NULL)
    {
       return false;
@@ -274,8 +558,10 @@ bool load_files()
 
 void clean_up()
 {
+   delete compositor;
    SDL_FreeSurface(dot);
-   SDL_FreeSurface(background);
+   delete streamer;
+   free_cooked(background);
    
    SDL_Quit();
 }
@@ -284,25 +570,78 @@ int main(int argc, char* args[])
 {
    bool quit = false;
 
+   if ((argc > 2) && (std::string(args[1]) == "--headless"))
+   {
+      headlessFrames = atoi(args[2]);
+   }
+   else if ((argc > 1) && (std::string(args[1]) == "--threaded"))
+   {
+      threaded = true;
+   }
+
    if (init() == false)
    {
       return 1;
    }
    
+   std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
    if (load_files() == false)
    {
       return 1;
    }
+   std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+   cout << "load_files: " << loadTime.count() << " ms\n";
+
+   compositor = new BandCompositor(std::thread::hardware_concurrency());
     
    Timer fps;
+   FrameStats stats;
+   int frame = 0;
    Dot myDot;
 
+   if (headlessFrames > 0)
+   {
+      // nobody is at the keyboard, so hold right and down to scroll the level
+      // zeroed first so state, mod and unicode don't go out as stack garbage
+      SDL_Event press;
+      memset(&press, 0, sizeof(press));
+      press.type = SDL_KEYDOWN;
+      press.key.state = SDL_PRESSED;
+      press.key.keysym.sym = SDLK_RIGHT;
+      SDL_PushEvent(&press);
+      press.key.keysym.sym = SDLK_DOWN;
+      SDL_PushEvent(&press);
+   }
+
+   SDL_Thread *simulator = NULL;
+   if (threaded == true)
+   {
+      inputLock = SDL_CreateMutex();
+      simulating = true;
+      simulator = SDL_CreateThread(simulate_thread, &myDot);
+      if (simulator == NULL)
+      {
+         return 1;
+      }
+   }
+
    while(quit == false)
    {
       fps.start();
+      std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
       while (SDL_PollEvent(&event))
       {
-         myDot.handle_input();
+         if (threaded == true)
+         {
+            // the dot belongs to the simulation thread
+            SDL_mutexP(inputLock);
+            pendingInput.push_back(event);
+            SDL_mutexV(inputLock);
+         }
+         else
+         {
+            myDot.handle_input(event);
+         }
 
          if (event.type == SDL_QUIT)
          {
@@ -310,11 +649,31 @@ int main(int argc, char* args[])
          }
       }
 
+      if (threaded == true)
+      {
+         if (quit == true)
+         {
+            continue;
+         }
+         // the simulation paces the frames, so this only waits for it
+         snapshots.acquire();
+         const Snapshot &snap = snapshots.read_buffer();
+         SDL_Rect view = snap.camera;
+         show_background(view);
+         apply_surface(snap.dotX - view.x, snap.dotY - view.y, dot, screen);
+
+         if (SDL_Flip(screen) == -1)
+         {
+            quit = true;
+         }
+         continue;
+      }
+
       myDot.move();
 
       myDot.set_camera();
 
-      apply_surface(0, 0, background, screen, &camera);
+      show_background(camera);
 
       myDot.show();
 
@@ -323,11 +682,31 @@ int main(int argc, char* args[])
          return 1;
       }
 
-      if (fps.get_ticks() < 1000 / FRAMES_PER_SECOND)
+      if (headlessFrames > 0)
       {
-         SDL_Delay((1000/FRAMES_PER_SECOND) - fps.get_ticks());
+         std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - frameStart;
+         stats.add(elapsed.count());
+         cout << "frame " << frame << " hash " << std::hex << hash_surface(screen) << std::dec << "\n";
+
+         frame++;
+         if (frame >= headlessFrames)
+         {
+            quit = true;
+         }
+         continue;
       }
+
+      cap_frame(fps);
    }
+
+   if (simulator != NULL)
+   {
+      simulating = false;
+      SDL_WaitThread(simulator, NULL);
+      SDL_DestroyMutex(inputLock);
+   }
+
+   stats.report();
    clean_up();
    return 0;
 }
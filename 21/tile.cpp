@@ -0,0 +1,87 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_image.h"
+#include "cooked_image.h"
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+
+using std::cout;
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+const int SCREEN_BPP = 32;
+
+// usage: tile bg.png 256 bg_tiles/bg
+// Cuts an image into size x size cooked tiles named prefix_column_row.raw,
+// converted to the display format like cook does, for TileStreamer to load.
+int main(int argc, char* args[])
+{
+   if (argc != 4)
+   {
+      cout << "usage: " << args[0] << " image size prefix\n";
+      return 1;
+   }
+
+   int size = atoi(args[2]);
+   if (size <= 0)
+   {
+      cout << args[2] << ": not a tile size\n";
+      return 1;
+   }
+
+   SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return 1;
+   }
+
+   if (SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE) == NULL)
+   {
+      return 1;
+   }
+
+   SDL_Surface *loadedImage = IMG_Load(args[1]);
+   if (loadedImage == NULL)
+   {
+      cout << args[1] << ": " << IMG_GetError() << "\n";
+      return 1;
+   }
+   SDL_Surface *image = SDL_DisplayFormat(loadedImage);
+   SDL_FreeSurface(loadedImage);
+
+   int result = 0;
+   int count = 0;
+   for (int y = 0; (y < image->h) && (result == 0); y += size)
+   {
+      for (int x = 0; (x < image->w) && (result == 0); x += size)
+      {
+         SDL_Rect clip = { (Sint16)x, (Sint16)y, (Uint16)size, (Uint16)size };
+         int w = (x + size > image->w) ? image->w - x : size;
+         int h = (y + size > image->h) ? image->h - y : size;
+         SDL_Surface *tile = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, image->format->Rmask, image->format->Gmask, image->format->Bmask, image->format->Amask);
+         SDL_BlitSurface(image, &clip, tile, NULL);
+         SDL_SetColorKey(tile, SDL_SRCCOLORKEY, SDL_MapRGB(tile->format, 0, 0xFF, 0xFF));
+
+         std::stringstream name;
+         name << args[3] << "_" << x / size << "_" << y / size << ".raw";
+         if (save_cooked(tile, name.str()) == false)
+         {
+            cout << name.str() << ": could not write\n";
+            result = 1;
+         }
+         SDL_FreeSurface(tile);
+         count++;
+      }
+   }
+
+   if (result == 0)
+   {
+      cout << count << " tiles of " << size << "x" << size << " from " << image->w << "x" << image->h << "\n";
+   }
+
+   SDL_FreeSurface(image);
+   SDL_Quit();
+   return result;
+}
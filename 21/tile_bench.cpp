@@ -0,0 +1,81 @@
+#include "SDL/SDL.h"
+#include "tile_streamer.h"
+#include <iostream>
+#include <chrono>
+
+using std::cout;
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+const int TILE_SIZE = 256;
+const int MAX_TILES = 32;
+const int FRAMES = 2000;
+
+SDL_Surface *target = NULL;
+
+// stands in for decoding a tile: a fresh surface with every pixel written
+SDL_Surface *make_tile(int column, int row, void *data)
+{
+   SDL_Surface *tile = SDL_CreateRGBSurface(SDL_SWSURFACE, TILE_SIZE, TILE_SIZE, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+   for (int y = 0; y < TILE_SIZE; y++)
+   {
+      Uint32 *pixels = (Uint32*)((Uint8*)tile->pixels + y * tile->pitch);
+      for (int x = 0; x < TILE_SIZE; x++)
+      {
+         pixels[x] = (column * 2654435761u) ^ (row * 40503u) ^ (y << 8) ^ x;
+      }
+   }
+   return tile;
+}
+
+void free_tile(SDL_Surface *tile)
+{
+   SDL_FreeSurface(tile);
+}
+
+// pans the camera corner to corner across a size x size level
+void bench(int size)
+{
+   TileStreamer streamer(size, size, TILE_SIZE, TILE_SIZE / 2, MAX_TILES, make_tile, free_tile, NULL);
+   SDL_Rect camera = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+   int peakBytes = 0;
+
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   for (int frame = 0; frame < FRAMES; frame++)
+   {
+      camera.x = (Sint16)((long long)(size - SCREEN_WIDTH) * frame / (FRAMES - 1));
+      camera.y = (Sint16)((long long)(size - SCREEN_HEIGHT) * frame / (FRAMES - 1));
+      streamer.update(camera);
+      streamer.draw(camera, target);
+      if (streamer.get_resident_bytes() > peakBytes)
+      {
+         peakBytes = streamer.get_resident_bytes();
+      }
+   }
+   std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+   cout << size << "x" << size << ": " << elapsed.count() / FRAMES << " ms/frame, "
+        << streamer.get_loads() << " loads, " << streamer.get_evictions() << " evictions, peak "
+        << peakBytes / 1024 << " KB resident vs " << (long long)size * size * 4 / 1024 << " KB for the whole level\n";
+}
+
+int main(int argc, char* args[])
+{
+   SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return 1;
+   }
+
+   target = SDL_CreateRGBSurface(SDL_SWSURFACE, SCREEN_WIDTH, SCREEN_HEIGHT, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+
+   for (int size = 1024; size <= 32768; size *= 2)
+   {
+      bench(size);
+   }
+
+   SDL_FreeSurface(target);
+   SDL_Quit();
+   return 0;
+}
@@ -0,0 +1,190 @@
+#ifndef TILE_STREAMER_H
+#define TILE_STREAMER_H
+
+#include "SDL/SDL.h"
+#include <map>
+
+// makes the surface for one tile, NULL if there is none
+typedef SDL_Surface *(*TileLoader)(int column, int row, void *data);
+typedef void (*TileFreer)(SDL_Surface *tile);
+
+// Keeps only the tiles of a big level that are on or near the camera.
+// update() loads whatever the camera (plus a margin) touches and then frees
+// the least recently used tiles until no more than maxResident are left,
+// never dropping one that is needed this frame.
+class TileStreamer
+{
+   private:
+      struct Tile
+      {
+         SDL_Surface *surface;
+         Uint32 lastUsed;
+      };
+      int tileSize;
+      int columns, rows;
+      int margin;
+      int maxResident;
+      TileLoader load;
+      TileFreer unload;
+      void *data;
+      std::map<int, Tile> tiles;
+      Uint32 frame;
+      int loads, evictions, residentBytes;
+      void visible(SDL_Rect &camera, int border, int &left, int &top, int &right, int &bottom);
+   public:
+      TileStreamer(int levelWidth, int levelHeight, int size, int prefetch, int maxTiles, TileLoader loader, TileFreer freer, void *loaderData);
+      ~TileStreamer();
+      void update(SDL_Rect &camera);
+      void draw(SDL_Rect &camera, SDL_Surface *destination);
+      int get_resident();
+      int get_resident_bytes();
+      int get_loads();
+      int get_evictions();
+};
+
+TileStreamer::TileStreamer(int levelWidth, int levelHeight, int size, int prefetch, int maxTiles, TileLoader loader, TileFreer freer, void *loaderData)
+{
+   tileSize = size;
+   columns = (levelWidth + size - 1) / size;
+   rows = (levelHeight + size - 1) / size;
+   margin = prefetch;
+   maxResident = maxTiles;
+   load = loader;
+   unload = freer;
+   data = loaderData;
+   frame = 0;
+   loads = 0;
+   evictions = 0;
+   residentBytes = 0;
+}
+
+TileStreamer::~TileStreamer()
+{
+   for (std::map<int, Tile>::iterator i = tiles.begin(); i != tiles.end(); i++)
+   {
+      unload(i->second.surface);
+   }
+}
+
+// the range of tile columns and rows within border pixels of the camera
+void TileStreamer::visible(SDL_Rect &camera, int border, int &left, int &top, int &right, int &bottom)
+{
+   left = (camera.x - border) / tileSize;
+   top = (camera.y - border) / tileSize;
+   right = (camera.x + camera.w + border - 1) / tileSize;
+   bottom = (camera.y + camera.h + border - 1) / tileSize;
+
+   if (left < 0)
+   {
+      left = 0;
+   }
+   if (top < 0)
+   {
+      top = 0;
+   }
+   if (right >= columns)
+   {
+      right = columns - 1;
+   }
+   if (bottom >= rows)
+   {
+      bottom = rows - 1;
+   }
+}
+
+void TileStreamer::update(SDL_Rect &camera)
+{
+   frame++;
+
+   int left, top, right, bottom;
+   visible(camera, margin, left, top, right, bottom);
+   for (int row = top; row <= bottom; row++)
+   {
+      for (int column = left; column <= right; column++)
+      {
+         int key = row * columns + column;
+         std::map<int, Tile>::iterator found = tiles.find(key);
+         if (found != tiles.end())
+         {
+            found->second.lastUsed = frame;
+            continue;
+         }
+
+         SDL_Surface *surface = load(column, row, data);
+         if (surface == NULL)
+         {
+            continue;
+         }
+         Tile tile;
+         tile.surface = surface;
+         tile.lastUsed = frame;
+         tiles[key] = tile;
+         residentBytes += surface->h * surface->pitch;
+         loads++;
+      }
+   }
+
+   while (tiles.size() > (size_t)maxResident)
+   {
+      std::map<int, Tile>::iterator oldest = tiles.begin();
+      for (std::map<int, Tile>::iterator i = tiles.begin(); i != tiles.end(); i++)
+      {
+         if (i->second.lastUsed < oldest->second.lastUsed)
+         {
+            oldest = i;
+         }
+      }
+      // everything left is in view, the budget is too small for the camera
+      if (oldest->second.lastUsed == frame)
+      {
+         break;
+      }
+      residentBytes -= oldest->second.surface->h * oldest->second.surface->pitch;
+      unload(oldest->second.surface);
+      tiles.erase(oldest);
+      evictions++;
+   }
+}
+
+void TileStreamer::draw(SDL_Rect &camera, SDL_Surface *destination)
+{
+   int left, top, right, bottom;
+   visible(camera, 0, left, top, right, bottom);
+   for (int row = top; row <= bottom; row++)
+   {
+      for (int column = left; column <= right; column++)
+      {
+         std::map<int, Tile>::iterator found = tiles.find(row * columns + column);
+         if (found == tiles.end())
+         {
+            continue;
+         }
+         SDL_Rect offset;
+         offset.x = column * tileSize - camera.x;
+         offset.y = row * tileSize - camera.y;
+         SDL_BlitSurface(found->second.surface, NULL, destination, &offset);
+      }
+   }
+}
+
+int TileStreamer::get_resident()
+{
+   return tiles.size();
+}
+
+int TileStreamer::get_resident_bytes()
+{
+   return residentBytes;
+}
+
+int TileStreamer::get_loads()
+{
+   return loads;
+}
+
+int TileStreamer::get_evictions()
+{
+   return evictions;
+}
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef BAND_COMPOSITOR_H
+#define BAND_COMPOSITOR_H
+
+#include "SDL/SDL.h"
+#include <vector>
+
+// Splits one big blit into horizontal bands and runs them on a fixed pool
+// of SDL threads, with the calling thread taking the first band. Every band
+// goes through SDL's own blitter for the same pixels it would have drawn in
+// one call, so the result is identical to SDL_BlitSurface. Only software
+// surfaces that need no locking are split; anything else is blitted whole.
+class BandCompositor
+{
+   private:
+      struct Band
+      {
+         SDL_Surface *source;
+         SDL_Surface *destination;
+         SDL_Rect src, dst;
+      };
+      struct Worker
+      {
+         BandCompositor *owner;
+         int index;
+         SDL_sem *go;
+         SDL_Thread *thread;
+      };
+      int threads;
+      bool quitting;
+      std::vector<Band> bands;
+      std::vector<Worker> workers;
+      SDL_sem *done;
+      static int work(void *data);
+   public:
+      BandCompositor(int threadCount);
+      ~BandCompositor();
+      void blit(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL);
+      int get_threads();
+};
+
+BandCompositor::BandCompositor(int threadCount)
+{
+   threads = threadCount < 1 ? 1 : threadCount;
+   quitting = false;
+   bands.resize(threads);
+   workers.resize(threads - 1);
+   done = SDL_CreateSemaphore(0);
+
+   // fill in every worker before any of them can start reading
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      workers[i].owner = this;
+      workers[i].index = i + 1;
+      workers[i].go = SDL_CreateSemaphore(0);
+   }
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      workers[i].thread = SDL_CreateThread(work, &workers[i]);
+   }
+}
+
+BandCompositor::~BandCompositor()
+{
+   quitting = true;
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      SDL_SemPost(workers[i].go);
+   }
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      SDL_WaitThread(workers[i].thread, NULL);
+      SDL_DestroySemaphore(workers[i].go);
+   }
+   SDL_DestroySemaphore(done);
+}
+
+int BandCompositor::work(void *data)
+{
+   Worker *worker = (Worker*)data;
+   BandCompositor *owner = worker->owner;
+   while (true)
+   {
+      SDL_SemWait(worker->go);
+      if (owner->quitting == true)
+      {
+         return 0;
+      }
+      Band &band = owner->bands[worker->index];
+      if ((band.src.w > 0) && (band.src.h > 0))
+      {
+         SDL_LowerBlit(band.source, &band.src, band.destination, &band.dst);
+      }
+      SDL_SemPost(owner->done);
+   }
+}
+
+void BandCompositor::blit(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip)
+{
+   if ((threads == 1) || SDL_MUSTLOCK(source) || SDL_MUSTLOCK(destination) || (source->flags & SDL_RLEACCEL))
+   {
+      SDL_Rect offset;
+      offset.x = x;
+      offset.y = y;
+      SDL_BlitSurface(source, clip, destination, &offset);
+      return;
+   }
+
+   // clip once, the same way SDL_BlitSurface would
+   int sx = 0, sy = 0;
+   int w = source->w, h = source->h;
+   if (clip != NULL)
+   {
+      sx = clip->x;
+      sy = clip->y;
+      w = clip->w;
+      h = clip->h;
+   }
+   int dx = x, dy = y;
+
+   if (sx < 0)
+   {
+      w += sx;
+      dx -= sx;
+      sx = 0;
+   }
+   if (sy < 0)
+   {
+      h += sy;
+      dy -= sy;
+      sy = 0;
+   }
+   if (sx + w > source->w)
+   {
+      w = source->w - sx;
+   }
+   if (sy + h > source->h)
+   {
+      h = source->h - sy;
+   }
+
+   SDL_Rect &c = destination->clip_rect;
+   if (dx < c.x)
+   {
+      sx += c.x - dx;
+      w -= c.x - dx;
+      dx = c.x;
+   }
+   if (dy < c.y)
+   {
+      sy += c.y - dy;
+      h -= c.y - dy;
+      dy = c.y;
+   }
+   if (dx + w > c.x + c.w)
+   {
+      w = c.x + c.w - dx;
+   }
+   if (dy + h > c.y + c.h)
+   {
+      h = c.y + c.h - dy;
+   }
+
+   if ((w <= 0) || (h <= 0))
+   {
+      return;
+   }
+
+   // a zero sized blit makes SDL build the source to destination mapping
+   // here, so the workers never race to do it
+   SDL_Rect none = { 0, 0, 0, 0 };
+   SDL_LowerBlit(source, &none, destination, &none);
+
+   int top = 0;
+   for (int i = 0; i < threads; i++)
+   {
+      int bottom = (h * (i + 1)) / threads;
+      Band &band = bands[i];
+      band.source = source;
+      band.destination = destination;
+      band.src.x = sx;
+      band.src.y = sy + top;
+      band.src.w = w;
+      band.src.h = bottom - top;
+      band.dst.x = dx;
+      band.dst.y = dy + top;
+      band.dst.w = w;
+      band.dst.h = bottom - top;
+      top = bottom;
+   }
+
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      SDL_SemPost(workers[i].go);
+   }
+
+   if (bands[0].src.h > 0)
+   {
+      SDL_LowerBlit(bands[0].source, &bands[0].src, bands[0].destination, &bands[0].dst);
+   }
+
+   for (size_t i = 0; i < workers.size(); i++)
+   {
+      SDL_SemWait(done);
+   }
+}
+
+int BandCompositor::get_threads()
+{
+   return threads;
+}
+
+#endif
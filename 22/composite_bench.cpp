@@ -0,0 +1,113 @@
+#include "SDL/SDL.h"
+#include "band_compositor.h"
+#include <string>
+#include <iostream>
+#include <thread>
+#include <chrono>
+
+using std::cout;
+
+const int FRAMES = 200;
+
+// FNV-1a over the visible pixels, to check every thread count draws the same thing
+Uint32 hash_surface(SDL_Surface* surface)
+{
+   Uint32 hash = 2166136261u;
+   int rowBytes = surface->w * surface->format->BytesPerPixel;
+   for (int y = 0; y < surface->h; y++)
+   {
+      Uint8 *row = (Uint8*)surface->pixels + y * surface->pitch;
+      for (int i = 0; i < rowBytes; i++)
+      {
+         hash = (hash ^ row[i]) * 16777619u;
+      }
+   }
+   return hash;
+}
+
+SDL_Surface *make_surface(int w, int h)
+{
+   return SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+}
+
+// a noisy background with some colorkey holes, like a real bg.png could have
+SDL_Surface *make_background(int w, int h)
+{
+   SDL_Surface *background = make_surface(w, h);
+   Uint32 colorkey = SDL_MapRGB(background->format, 0, 0xFF, 0xFF);
+   Uint32 seed = 1;
+   for (int y = 0; y < h; y++)
+   {
+      Uint32 *row = (Uint32*)((Uint8*)background->pixels + y * background->pitch);
+      for (int x = 0; x < w; x++)
+      {
+         seed = seed * 1103515245 + 12345;
+         row[x] = ((seed >> 16) % 16 == 0) ? colorkey : (seed & 0x00FFFFFF);
+      }
+   }
+   SDL_SetColorKey(background, SDL_SRCCOLORKEY, colorkey);
+   return background;
+}
+
+void bench(std::string name, int w, int h, int maxThreads)
+{
+   SDL_Surface *background = make_background(w, h);
+   SDL_Surface *target = make_surface(w, h);
+   double single = 0;
+   Uint32 expected = 0;
+
+   cout << name << " (" << w << "x" << h << ")\n";
+   for (int threads = 1; threads <= maxThreads; threads++)
+   {
+      BandCompositor compositor(threads);
+      SDL_FillRect(target, NULL, 0);
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for (int i = 0; i < FRAMES; i++)
+      {
+         compositor.blit(0, 0, background, target);
+      }
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      double perFrame = elapsed.count() / FRAMES;
+
+      Uint32 hash = hash_surface(target);
+      if (threads == 1)
+      {
+         single = perFrame;
+         expected = hash;
+      }
+
+      cout << "   " << threads << " threads: " << perFrame << " ms/frame, speedup " << single / perFrame;
+      if (hash != expected)
+      {
+         cout << ", OUTPUT DIFFERS";
+      }
+      cout << "\n";
+   }
+
+   SDL_FreeSurface(background);
+   SDL_FreeSurface(target);
+}
+
+int main(int argc, char* args[])
+{
+   SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return 1;
+   }
+
+   int maxThreads = std::thread::hardware_concurrency();
+   if (maxThreads < 1)
+   {
+      maxThreads = 1;
+   }
+
+   bench("640x480", 640, 480, maxThreads);
+   bench("1080p", 1920, 1080, maxThreads);
+   bench("4K", 3840, 2160, maxThreads);
+
+   SDL_Quit();
+   return 0;
+}
@@ -1,7 +1,15 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
+#include "band_compositor.h"
+#include "cooked_image.h"
 #include <string>
 #include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <time.h>
 
 using std::cout;
 
@@ -19,9 +27,13 @@ const int LEVEL_HEIGHT = 960;
 SDL_Surface *dot = NULL;
 SDL_Surface *background = NULL;
 SDL_Surface *screen = NULL;
+BandCompositor *compositor = NULL;
 
 SDL_Event event;
 
+// run this many frames offscreen as fast as possible, 0 for a normal window
+int headlessFrames = 0;
+
 SDL_Rect camera = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
 
 void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
@@ -47,13 +59,16 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -61,23 +76,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -86,28 +110,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -116,8 +151,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -237,9 +272,78 @@ void Dot::set_camera()
    }
 }
 
+class FrameStats
+{
+   private:
+      std::vector<double> times;
+   public:
+      void add(double ms);
+      void report();
+};
+
+void FrameStats::add(double ms)
+{
+   times.push_back(ms);
+}
+
+void FrameStats::report()
+{
+   if (times.empty() == true)
+   {
+      return;
+   }
+
+   std::vector<double> sorted = times;
+   std::sort(sorted.begin(), sorted.end());
+
+   double total = 0;
+   for (size_t i = 0; i < sorted.size(); i++)
+   {
+      total += sorted[i];
+   }
+
+   cout << "frames: " << sorted.size() << "\n";
+   cout << "total: " << total << " ms\n";
+   cout << "min: " << sorted.front() << " ms\n";
+   cout << "avg: " << total / sorted.size() << " ms\n";
+   cout << "median: " << sorted[sorted.size() / 2] << " ms\n";
+   cout << "p99: " << sorted[(sorted.size() * 99) / 100] << " ms\n";
+   cout << "max: " << sorted.back() << " ms\n";
+   if (total > 0)
+   {
+      cout << "fps: " << sorted.size() * 1000.0 / total << "\n";
+   }
+}
+
+// FNV-1a over the visible pixels, so two runs can be compared frame by frame
+Uint32 hash_surface(SDL_Surface* surface)
+{
+   Uint32 hash = 2166136261u;
+   int rowBytes = surface->w * surface->format->BytesPerPixel;
+
+   SDL_LockSurface(surface);
+   for (int y = 0; y < surface->h; y++)
+   {
+      Uint8 *row = (Uint8*)surface->pixels + y * surface->pitch;
+      for (int i = 0; i < rowBytes; i++)
+      {
+         hash = (hash ^ row[i]) * 16777619u;
+      }
+   }
+   SDL_UnlockSurface(surface);
+
+   return hash;
+}
+
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (headlessFrames > 0)
+   {
+      // the dummy driver gives us an in-memory screen and no window
+      SDL_putenv("SDL_VIDEODRIVER=dummy");
+   }
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -263,7 +367,12 @@ bool load_files()
    {
       return false;
    }
-   background = load_image("bg.png");
+   // bg.raw comes from "cook bg.png bg.raw"; decode the png if it isn't there
+   background = load_cooked("bg.raw");
+   if (background == NULL)
+   {
+      background = load_image("bg.png");
+   }
    if (background == NULL)
    {
       return false;
@@ -274,8 +383,9 @@ bool load_files()
 
 void clean_up()
 {
+   delete compositor;
    SDL_FreeSurface(dot);
-   SDL_FreeSurface(background);
+   free_cooked(background);
    
    SDL_Quit();
 }
@@ -283,6 +393,11 @@ void clean_up()
 int main(int argc, char* args[])
 {
    bool quit = false;
+
+   if ((argc > 2) && (std::string(args[1]) == "--headless"))
+   {
+      headlessFrames = atoi(args[2]);
+   }
    int bgX = 0, bgY = 0;
 
    if (init() == false)
@@ -290,16 +405,24 @@ int main(int argc, char* args[])
       return 1;
    }
    
+   std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
    if (load_files() == false)
    {
       return 1;
    }
+   std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+   cout << "load_files: " << loadTime.count() << " ms\n";
+
+   compositor = new BandCompositor(std::thread::hardware_concurrency());
     
    Timer fps;
+   FrameStats stats;
+   int frame = 0;
 
    while(quit == false)
    {
       fps.start();
+      std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
 
       while (SDL_PollEvent(&event))
       {
@@ -316,8 +439,8 @@ int main(int argc, char* args[])
          bgX = 0;
       }
 
-      apply_surface(bgX, bgY, background, screen);
-      apply_surface(bgX + background->w, bgY, background, screen);
+      compositor->blit(bgX, bgY, background, screen);
+      compositor->blit(bgX + background->w, bgY, background, screen);
       apply_surface(310, 230, dot, screen);
 
       if (SDL_Flip(screen) == -1)
@@ -325,11 +448,28 @@ int main(int argc, char* args[])
          return 1;
       }
 
-      if (fps.get_ticks() < 1000 / FRAMES_PER_SECOND)
+      if (headlessFrames > 0)
+      {
+         std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - frameStart;
+         stats.add(elapsed.count());
+         cout << "frame " << frame << " hash " << std::hex << hash_surface(screen) << std::dec << "\n";
+
+         frame++;
+         if (frame >= headlessFrames)
+         {
+            quit = true;
+         }
+         continue;
+      }
+
+      long long frameMicros = 1000000 / FRAMES_PER_SECOND;
+      if (fps.get_micros() < frameMicros)
       {
-         SDL_Delay((1000/FRAMES_PER_SECOND) - fps.get_ticks());
+         SDL_Delay((frameMicros - fps.get_micros() + 999) / 1000);
       }
    }
+
+   stats.report();
    clean_up();
    return 0;
 }
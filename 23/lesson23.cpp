@@ -1,18 +1,22 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
 #include "SDL/SDL_ttf.h"
+#include "glyph_atlas.h"
+#include "text_cache.h"
 #include <string>
+#include <vector>
 #include <iostream>
 
 const int FRAMES_PER_SECOND = 40;
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 480;
 const int SCREEN_BPP = 32;
+const int MAX_INPUT = 256;
 
 SDL_Surface *background = NULL;
 SDL_Surface *screen = NULL;
 TTF_Font *font = NULL;
-SDL_Surface *message = NULL;
+GlyphAtlas *glyphs = NULL;
 SDL_Color textColor = {255, 255, 255};
 
 
@@ -41,11 +45,46 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
+SDL_Surface *render_text(void *face, int style, const char *text, SDL_Color color)
+{
+   TTF_Font *ttf = (TTF_Font*)face;
+   int previous = TTF_GetFontStyle(ttf);
+   // SDL_ttf drops its glyph cache on every style change, so only on a real one
+   if (previous != style)
+   {
+      TTF_SetFontStyle(ttf, style);
+   }
+   SDL_Surface *surface = TTF_RenderText_Solid(ttf, text, color);
+   if (previous != style)
+   {
+      TTF_SetFontStyle(ttf, previous);
+   }
+   return surface;
+}
+
+// the prompts are asked for every frame but only rendered once
+TextCache textCache(64 * 1024, render_text);
+
+// Keeps the typed text drawn in its own line surface along with where every
+// glyph went. A new character is one glyph blit at the end of the line and
+// backspace clears the last glyph, so a keystroke costs the same however
+// long the text already is.
 class StringInput
 {
    private:
+      struct Placed
+      {
+         int ch;
+         // where its pen was, and the width of the line up to and including it
+         int pen, right;
+      };
       std::string str;
+      std::vector<Placed> layout;
       SDL_Surface *text;
+      Uint32 key;
+      bool reserve(int width);
+      void append(int ch);
+      void remove_last();
    public:
       StringInput();
       ~StringInput();
@@ -57,6 +96,7 @@ StringInput::StringInput()
 {
    str = "";
    text = NULL;
+   key = 0;
    SDL_EnableUNICODE(SDL_ENABLE);
 }
 
@@ -66,55 +106,152 @@ StringInput::~StringInput()
    SDL_EnableUNICODE(SDL_DISABLE);
 }
 
+// grows the line surface by doubling, so appends stay cheap on average
+bool StringInput::reserve(int width)
+{
+   if ((text != NULL) && (text->w >= width))
+   {
+      return true;
+   }
+
+   int capacity = (text == NULL) ? 256 : text->w * 2;
+   while (capacity < width)
+   {
+      capacity *= 2;
+   }
+
+   SDL_PixelFormat *display = screen->format;
+   SDL_Surface *grown = SDL_CreateRGBSurface(SDL_SWSURFACE, capacity, glyphs->height(), display->BitsPerPixel,
+                                             display->Rmask, display->Gmask, display->Bmask, 0);
+   if (grown == NULL)
+   {
+      return false;
+   }
+
+   // anything but the text color works as the key
+   key = SDL_MapRGB(grown->format, 255 - textColor.r, 255 - textColor.g, 255 - textColor.b);
+   SDL_FillRect(grown, NULL, key);
+   SDL_SetColorKey(grown, SDL_SRCCOLORKEY, key);
+   if (text != NULL)
+   {
+      apply_surface(0, 0, text, grown);
+      SDL_FreeSurface(text);
+   }
+   text = grown;
+   return true;
+}
+
+void StringInput::append(int ch)
+{
+   int pen = 0, right = 0;
+   if (layout.empty() == true)
+   {
+      // SDL_ttf shifts the whole line right when the first glyph hangs left
+      if (glyphs->get_left(ch) < 0)
+      {
+         pen = -glyphs->get_left(ch);
+      }
+   }
+   else
+   {
+      Placed &last = layout.back();
+      pen = last.pen + glyphs->get_advance(last.ch) + glyphs->kern(last.ch, ch);
+      right = last.right;
+   }
+   if (pen + glyphs->get_right(ch) > right)
+   {
+      right = pen + glyphs->get_right(ch);
+   }
+
+   if (reserve(right) == false)
+   {
+      return;
+   }
+
+   glyphs->draw_glyph(pen, 0, ch, text);
+
+   Placed placed;
+   placed.ch = ch;
+   placed.pen = pen;
+   placed.right = right;
+   layout.push_back(placed);
+   str += (char)ch;
+}
+
+void StringInput::remove_last()
+{
+   Placed last = layout.back();
+   layout.pop_back();
+   str.erase(str.length() - 1);
+
+   // clear everything the glyph could have touched
+   SDL_Rect area;
+   int left = last.pen + (glyphs->get_left(last.ch) < 0 ? glyphs->get_left(last.ch) : 0);
+   area.x = left < 0 ? 0 : left;
+   area.y = 0;
+   area.w = last.pen + glyphs->get_right(last.ch) - area.x;
+   area.h = text->h;
+   SDL_FillRect(text, &area, key);
+
+   // and put back the ink of earlier glyphs that reached into that space
+   for (int i = layout.size() - 1; i >= 0; i--)
+   {
+      if (layout[i].pen + glyphs->get_right(layout[i].ch) <= area.x)
+      {
+         break;
+      }
+      glyphs->draw_glyph(layout[i].pen, 0, layout[i].ch, text);
+   }
+}
+
 void StringInput::handle_input()
 {
    if (event.type == SDL_KEYDOWN)
    {
-      std::string temp = str;
-      if (str.length() <= 16)
-      {
-         Uint16 unichar = event.key.keysym.unicode;
+      Uint16 unichar = event.key.keysym.unicode;
 
+      if (str.length() < MAX_INPUT)
+      {
          if (unichar == (Uint16)' ')
          {
-            str += (char)unichar;
+            append(unichar);
          }
          else if ((unichar >= (Uint16)'0') && (unichar <= (Uint16)'9'))
          {
-            str += (char)unichar;
+            append(unichar);
          }
          else if ((unichar >= (Uint16)'A') && (unichar <= (Uint16)'Z'))
          {
-            str += (char)unichar;
+            append(unichar);
          }
          else if ((unichar >= (Uint16)'a') && (unichar <= (Uint16)'z'))
          {
-            str += (char)unichar;
-         }
-         if ((event.key.keysym.sym == SDLK_BACKSPACE) && (str.length() != 0))
-         {
-            str.erase(str.length() - 1);
-         }
-         if (str != temp)
-         {
-            SDL_FreeSurface(text);
-            text = TTF_RenderText_Solid(font, str.c_str(), textColor);
+            append(unichar);
          }
       }
+      if ((event.key.keysym.sym == SDLK_BACKSPACE) && (str.length() != 0))
+      {
+         remove_last();
+      }
    }
 }
 
 void StringInput::show_centered() 
 {
-   if (text != NULL)
+   if (layout.empty() == false)
    {
-      apply_surface((SCREEN_WIDTH - text->w) / 2, (SCREEN_HEIGHT - text->h) / 2, text, screen);
+      SDL_Rect clip;
+      clip.x = 0;
+      clip.y = 0;
+      clip.w = layout.back().right;
+      clip.h = text->h;
+      apply_surface((SCREEN_WIDTH - clip.w) / 2, (SCREEN_HEIGHT - clip.h) / 2, text, screen, &clip);
    }
 }
 
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -150,11 +287,20 @@ bool load_files()
       return false;
    }
 
+   glyphs = new GlyphAtlas(font, textColor);
+   if (glyphs->is_ready() == false)
+   {
+      return false;
+   }
+
    return true;
 }
 
 void clean_up()
 {
+   delete glyphs;
+   textCache.report();
+   textCache.clear();
    SDL_FreeSurface(background);
    
    SDL_Quit();
@@ -179,7 +325,7 @@ int main(int argc, char* args[])
       return 1;
    }
 
-   message = TTF_RenderText_Solid(font, "New High Score! Enter Name:", textColor);
+   const char *prompt = "New High Score! Enter Name:";
 
 
    while(quit == false)
@@ -194,8 +340,7 @@ int main(int argc, char* args[])
             if ((event.type == SDL_KEYDOWN) && (event.key.keysym.sym == SDLK_RETURN))
             {
                nameEntered = true;
-               SDL_FreeSurface(message);
-               message = TTF_RenderText_Solid(font, "Rank: 1st", textColor);
+               prompt = "Rank: 1st";
             }
          }
          
@@ -205,6 +350,7 @@ int main(int argc, char* args[])
          }
       }
 
+      SDL_Surface *message = textCache.get(font, TTF_GetFontStyle(font), textColor, prompt);
       apply_surface(0, 0, background, screen);
       apply_surface((SCREEN_WIDTH - message->w)/2,((SCREEN_HEIGHT/2) - message->h)/2, message, screen);
       name.show_centered();
@@ -213,6 +359,7 @@ int main(int argc, char* args[])
       {
          return 1;
       }
+      textCache.next_frame();
 
    }
    clean_up();
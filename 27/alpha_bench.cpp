@@ -0,0 +1,323 @@
+#include "SDL/SDL.h"
+#include "SDL/SDL_image.h"
+#include "alpha_blit.h"
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+using std::cout;
+
+const int SCREEN_WIDTH = 640;
+const int SCREEN_HEIGHT = 480;
+const int SCREEN_BPP = 32;
+const int BLITS = 2000;
+// SDL 1.2 blends with (s - d) * alpha / 256 and averages at alpha 128, where
+// alpha_row rounds (s * alpha + d * (255 - alpha)) / 255, so the two can land
+// a step or two apart on each channel
+const int SDL_TOLERANCE = 2;
+const int ALPHAS[] = { SDL_ALPHA_TRANSPARENT, 1, 77, 128, 254, SDL_ALPHA_OPAQUE };
+
+SDL_Surface *screen = NULL;
+SDL_Surface *target = NULL;
+// what SDL_BlitSurface drew, for alpha_blit to be held against
+SDL_Surface *expected = NULL;
+
+SDL_Surface *load_image(std::string filename)
+{
+   SDL_Surface* loadedImage = NULL;
+   SDL_Surface* optimizedImage = NULL;
+   loadedImage = IMG_Load(filename.c_str());
+   if (loadedImage != NULL)
+   {
+      optimizedImage = SDL_DisplayFormat(loadedImage);
+      SDL_FreeSurface(loadedImage);
+      Uint32 colorkey = SDL_MapRGB(optimizedImage->format, 0, 0xFF, 0xFF);
+      SDL_SetColorKey(optimizedImage, SDL_SRCCOLORKEY, colorkey);
+   }
+   return optimizedImage;
+}
+
+// spreads the blits over the target so they don't all hit the same cache lines
+void blit_position(int i, SDL_Surface* source, SDL_Rect* offset)
+{
+   offset->x = (i * 37) % (SCREEN_WIDTH - source->w + 1);
+   offset->y = (i * 91) % (SCREEN_HEIGHT - source->h + 1);
+}
+
+void report(std::string name, SDL_Surface* source, Uint32 ms)
+{
+   double pixels = (double)BLITS * source->w * source->h;
+   cout << "   " << name << ": " << ms << " ms";
+   if (ms > 0)
+   {
+      cout << ", " << pixels / (ms * 1000.0) << " Mpixels/s";
+   }
+   cout << "\n";
+}
+
+// the blend as written, with the divide, for alpha_row_scalar's shortcut to match
+Uint32 blend(Uint32 s, Uint32 d, int alpha)
+{
+   Uint32 out = 0;
+   for (int shift = 0; shift < 32; shift += 8)
+   {
+      Uint32 x = ((s >> shift) & 0xFF) * alpha + ((d >> shift) & 0xFF) * (255 - alpha);
+      out |= ((x + 127) / 255) << shift;
+   }
+   return out;
+}
+
+// Every row kernel the CPU can run has to give exactly what the scalar one
+// does, over the widths that leave each vector loop a tail, and the scalar
+// one has to give the blend as written.
+bool check_rows()
+{
+   const int MAX_WIDTH = 67;
+   Uint32 src[MAX_WIDTH], dst[MAX_WIDTH], want[MAX_WIDTH], got[MAX_WIDTH];
+   const Uint32 KEY = 0x0000FFFF;
+
+   struct Kernel
+   {
+      const char *name;
+      AlphaRow row;
+      bool supported;
+   };
+   Kernel kernels[3] = { { "scalar", alpha_row_scalar, true } };
+   int count = 1;
+#ifdef ALPHA_BLIT_X86
+   __builtin_cpu_init();
+   Kernel sse2 = { "sse2", alpha_row_sse2, __builtin_cpu_supports("sse2") != 0 };
+   Kernel avx2 = { "avx2", alpha_row_avx2, __builtin_cpu_supports("avx2") != 0 };
+   kernels[count++] = sse2;
+   kernels[count++] = avx2;
+#endif
+
+   srand(27);
+   bool same = true;
+   for (int k = 0; k < count; k++)
+   {
+      if (kernels[k].supported == false)
+      {
+         cout << "   " << kernels[k].name << ": not on this CPU\n";
+         continue;
+      }
+      bool kernelSame = true;
+      for (int keyed = 0; keyed < 2; keyed++)
+      {
+         for (size_t a = 0; a < sizeof(ALPHAS) / sizeof(ALPHAS[0]); a++)
+         {
+            for (int w = 0; w <= MAX_WIDTH; w++)
+            {
+               for (int i = 0; i < w; i++)
+               {
+                  src[i] = (rand() % 5 == 0) ? KEY : ((Uint32)rand() << 16) ^ (Uint32)rand();
+                  dst[i] = ((Uint32)rand() << 16) ^ (Uint32)rand();
+                  want[i] = dst[i];
+                  got[i] = dst[i];
+               }
+               Uint32 keymask = (keyed == 1) ? 0xFFFFFFFF : 0;
+               for (int i = 0; i < w; i++)
+               {
+                  if ((keymask == 0) || (src[i] != KEY))
+                  {
+                     want[i] = blend(src[i], dst[i], ALPHAS[a]);
+                  }
+               }
+               kernels[k].row(src, got, w, ALPHAS[a], KEY, keymask);
+               for (int i = 0; (kernelSame == true) && (i < w); i++)
+               {
+                  if (got[i] != want[i])
+                  {
+                     cout << "   " << kernels[k].name << " DIFFERS at alpha " << ALPHAS[a] << (keyed == 1 ? " keyed" : "")
+                          << ", width " << w << ", pixel " << i << "\n";
+                     kernelSame = false;
+                  }
+               }
+            }
+         }
+      }
+      if (kernelSame == true)
+      {
+         cout << "   " << kernels[k].name << " matches the blend\n";
+      }
+      same = kernelSame && same;
+   }
+   return same;
+}
+
+int channel_gap(Uint32 a, Uint32 b, Uint32 mask)
+{
+   int gap = 0;
+   for (int shift = 0; shift < 32; shift += 8)
+   {
+      if (((mask >> shift) & 0xFF) != 0)
+      {
+         int d = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+         gap = d > gap ? d : gap;
+      }
+   }
+   return gap;
+}
+
+// the byte SDL leaves free in the display format is left out, SDL's own
+// blitters don't agree on what goes in it
+bool close_pixels(SDL_Surface* a, SDL_Surface* b)
+{
+   Uint32 mask = a->format->Rmask | a->format->Gmask | a->format->Bmask;
+   SDL_LockSurface(a);
+   SDL_LockSurface(b);
+   bool close = true;
+   for (int y = 0; (close == true) && (y < a->h); y++)
+   {
+      Uint32 *rowA = (Uint32*)((Uint8*)a->pixels + y * a->pitch);
+      Uint32 *rowB = (Uint32*)((Uint8*)b->pixels + y * b->pitch);
+      for (int x = 0; (close == true) && (x < a->w); x++)
+      {
+         close = channel_gap(rowA[x], rowB[x], mask) <= SDL_TOLERANCE;
+      }
+   }
+   SDL_UnlockSurface(b);
+   SDL_UnlockSurface(a);
+   return close;
+}
+
+// One blit both ways onto the same background: the pixels have to come out
+// within SDL_TOLERANCE and the rect written back into offset the same.
+bool check_blit(SDL_Surface* source, SDL_Rect* clip, int x, int y)
+{
+   Uint32 background = SDL_MapRGB(target->format, 0x40, 0x80, 0xC0);
+   SDL_FillRect(expected, NULL, background);
+   SDL_FillRect(target, NULL, background);
+
+   SDL_Rect sdlOffset = { (Sint16)x, (Sint16)y, 0, 0 };
+   SDL_Rect ourOffset = sdlOffset;
+   SDL_BlitSurface(source, clip, expected, &sdlOffset);
+   if (alpha_blit(source, clip, target, &ourOffset) == false)
+   {
+      cout << "   alpha_blit turned down a surface it should take\n";
+      return false;
+   }
+
+   if ((close_pixels(expected, target) == false) ||
+       (memcmp(&sdlOffset, &ourOffset, sizeof(SDL_Rect)) != 0))
+   {
+      cout << "   alpha_blit at alpha " << (int)source->format->alpha << ((source->flags & SDL_SRCCOLORKEY) ? " keyed" : "")
+           << ", " << x << "," << y << (clip != NULL ? " with a clip" : "") << " DIFFERS from SDL_BlitSurface\n";
+      return false;
+   }
+   return true;
+}
+
+// a spread of positions and every way a blit can be clipped, at each alpha
+bool check_blits(SDL_Surface* source)
+{
+   bool same = true;
+   for (size_t a = 0; a < sizeof(ALPHAS) / sizeof(ALPHAS[0]); a++)
+   {
+      SDL_SetAlpha(source, SDL_SRCALPHA, ALPHAS[a]);
+      SDL_Rect offset;
+      for (int i = 0; i < 8; i++)
+      {
+         blit_position(i, source, &offset);
+         same = check_blit(source, NULL, offset.x, offset.y) && same;
+      }
+
+      int w = source->w, h = source->h;
+      SDL_Rect inner = { (Sint16)(w / 4), (Sint16)(h / 4), (Uint16)(w / 2 + 1), (Uint16)(h / 2) };
+      SDL_Rect outside = { (Sint16)(-w / 4), (Sint16)(-h / 4), (Uint16)w, (Uint16)h };
+      same = check_blit(source, NULL, -w / 2, -h / 2) && same;
+      same = check_blit(source, NULL, SCREEN_WIDTH - w / 2, SCREEN_HEIGHT - h / 2) && same;
+      same = check_blit(source, NULL, SCREEN_WIDTH, 0) && same;
+      same = check_blit(source, &inner, 10, 10) && same;
+      same = check_blit(source, &outside, 10, 10) && same;
+
+      SDL_Rect window = { 100, 100, (Uint16)(w / 2 + 1), (Uint16)(h / 2 + 1) };
+      SDL_SetClipRect(expected, &window);
+      SDL_SetClipRect(target, &window);
+      same = check_blit(source, NULL, 100 - w / 3, 100 - h / 3) && same;
+      SDL_SetClipRect(expected, NULL);
+      SDL_SetClipRect(target, NULL);
+   }
+   return same;
+}
+
+bool bench(std::string filename)
+{
+   SDL_Surface *source = load_image(filename);
+   if (source == NULL)
+   {
+      cout << filename << ": could not load\n";
+      return false;
+   }
+
+   cout << filename << " (" << source->w << "x" << source->h << ")\n";
+   Uint32 key = source->format->colorkey;
+   bool same = check_blits(source);
+   SDL_SetColorKey(source, 0, 0);
+   same = check_blits(source) && same;
+   cout << "   alpha_blit " << (same ? "matches" : "does not match") << " SDL_BlitSurface, keyed and not\n";
+
+   SDL_SetColorKey(source, SDL_SRCCOLORKEY, key);
+   SDL_SetAlpha(source, SDL_SRCALPHA, 128);
+   SDL_Rect offset;
+
+   Uint32 start = SDL_GetTicks();
+   for (int i = 0; i < BLITS; i++)
+   {
+      blit_position(i, source, &offset);
+      SDL_BlitSurface(source, NULL, target, &offset);
+   }
+   report("SDL_BlitSurface", source, SDL_GetTicks() - start);
+
+   start = SDL_GetTicks();
+   for (int i = 0; i < BLITS; i++)
+   {
+      blit_position(i, source, &offset);
+      alpha_blit(source, NULL, target, &offset);
+   }
+   report("alpha_blit", source, SDL_GetTicks() - start);
+
+   SDL_FreeSurface(source);
+   return same;
+}
+
+// usage: alpha_bench
+// Checks every row kernel this CPU can run against the plain blend, then
+// alpha_blit against SDL_BlitSurface with SDL_SRCALPHA at alphas from 0 to
+// 255, with and without the colorkey, and times the two at alpha 128.
+// Exits 1 when anything differs.
+int main(int argc, char* args[])
+{
+   // no window is needed, only a display format to convert to
+   SDL_putenv("SDL_VIDEODRIVER=dummy");
+
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
+   {
+      return 1;
+   }
+
+   screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT, SCREEN_BPP, SDL_SWSURFACE);
+   if (screen == NULL)
+   {
+      return 1;
+   }
+
+   target = SDL_DisplayFormat(screen);
+   expected = SDL_DisplayFormat(screen);
+   if ((target == NULL) || (expected == NULL))
+   {
+      return 1;
+   }
+
+   cout << "row kernels\n";
+   bool same = check_rows();
+   same = bench("fadeout.png") && same;
+   same = bench("../20/foo.png") && same;
+   same = bench("../16/dot.bmp") && same;
+
+   SDL_FreeSurface(expected);
+   SDL_FreeSurface(target);
+   SDL_Quit();
+   return same ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+#ifndef ALPHA_BLIT_H
+#define ALPHA_BLIT_H
+
+#include "SDL/SDL.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ALPHA_BLIT_X86
+#include <immintrin.h>
+#endif
+
+// blends one row of 32bpp src over dst with a constant alpha, skipping
+// pixels that match the key when keymask is non-zero
+typedef void (*AlphaRow)(const Uint32 *src, Uint32 *dst, int w, int alpha, Uint32 key, Uint32 keymask);
+
+static void alpha_row_scalar(const Uint32 *src, Uint32 *dst, int w, int alpha, Uint32 key, Uint32 keymask)
+{
+   for (int i = 0; i < w; i++)
+   {
+      if ((keymask != 0) && ((src[i] & keymask) == key))
+      {
+         continue;
+      }
+      Uint32 s = src[i], d = dst[i], out = 0;
+      for (int shift = 0; shift < 32; shift += 8)
+      {
+         // (x + 128) / 255 without the divide, exact for 0..255*255
+         Uint32 t = ((s >> shift) & 0xFF) * alpha + ((d >> shift) & 0xFF) * (255 - alpha) + 128;
+         out |= (((t + (t >> 8)) >> 8) & 0xFF) << shift;
+      }
+      dst[i] = out;
+   }
+}
+
+#ifdef ALPHA_BLIT_X86
+__attribute__((target("sse2")))
+static inline __m128i alpha_blend_sse2(__m128i s, __m128i d, __m128i a, __m128i ia)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128i half = _mm_set1_epi16(128);
+
+   __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), a), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia));
+   __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), a), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia));
+   lo = _mm_add_epi16(lo, half);
+   hi = _mm_add_epi16(hi, half);
+   lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+   hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+   return _mm_packus_epi16(lo, hi);
+}
+
+__attribute__((target("sse2")))
+static void alpha_row_sse2(const Uint32 *src, Uint32 *dst, int w, int alpha, Uint32 key, Uint32 keymask)
+{
+   __m128i a = _mm_set1_epi16(alpha);
+   __m128i ia = _mm_set1_epi16(255 - alpha);
+   __m128i k = _mm_set1_epi32(key);
+   __m128i m = _mm_set1_epi32(keymask);
+   int i = 0;
+   for (; i + 4 <= w; i += 4)
+   {
+      __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+      __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+      __m128i out = alpha_blend_sse2(s, d, a, ia);
+      if (keymask != 0)
+      {
+         __m128i hole = _mm_cmpeq_epi32(_mm_and_si128(s, m), k);
+         out = _mm_or_si128(_mm_and_si128(hole, d), _mm_andnot_si128(hole, out));
+      }
+      _mm_storeu_si128((__m128i*)(dst + i), out);
+   }
+   alpha_row_scalar(src + i, dst + i, w - i, alpha, key, keymask);
+}
+
+__attribute__((target("avx2")))
+static void alpha_row_avx2(const Uint32 *src, Uint32 *dst, int w, int alpha, Uint32 key, Uint32 keymask)
+{
+   __m256i zero = _mm256_setzero_si256();
+   __m256i half = _mm256_set1_epi16(128);
+   __m256i a = _mm256_set1_epi16(alpha);
+   __m256i ia = _mm256_set1_epi16(255 - alpha);
+   __m256i k = _mm256_set1_epi32(key);
+   __m256i m = _mm256_set1_epi32(keymask);
+   int i = 0;
+   for (; i + 8 <= w; i += 8)
+   {
+      __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+      __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+
+      // unpack and pack both work within 128 bit lanes, so the order comes back out right
+      __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), a), _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), ia));
+      __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), a), _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), ia));
+      lo = _mm256_add_epi16(lo, half);
+      hi = _mm256_add_epi16(hi, half);
+      lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+      hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+      __m256i out = _mm256_packus_epi16(lo, hi);
+
+      if (keymask != 0)
+      {
+         __m256i hole = _mm256_cmpeq_epi32(_mm256_and_si256(s, m), k);
+         out = _mm256_blendv_epi8(out, d, hole);
+      }
+      _mm256_storeu_si256((__m256i*)(dst + i), out);
+   }
+   alpha_row_sse2(src + i, dst + i, w - i, alpha, key, keymask);
+}
+#endif
+
+static AlphaRow alpha_row_select()
+{
+#ifdef ALPHA_BLIT_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+   {
+      return alpha_row_avx2;
+   }
+   if (__builtin_cpu_supports("sse2"))
+   {
+      return alpha_row_sse2;
+   }
+#endif
+   return alpha_row_scalar;
+}
+
+static AlphaRow alpha_row = alpha_row_select();
+
+// Blits a 32bpp surface with per-surface alpha (SDL_SetAlpha) onto a 32bpp
+// surface of the same format, honouring its colorkey. Clips like
+// SDL_BlitSurface and writes the drawn area back into offset. Alpha 0 draws
+// nothing and alpha 255 without a colorkey is a straight row copy.
+// Returns false when SDL's own blitter has to do it.
+static bool alpha_blit(SDL_Surface* source, SDL_Rect* clip, SDL_Surface* destination, SDL_Rect* offset)
+{
+   SDL_PixelFormat *sf = source->format;
+   SDL_PixelFormat *df = destination->format;
+
+   if ((sf->BytesPerPixel != 4) || (df->BytesPerPixel != 4) || (sf->Amask != 0))
+   {
+      return false;
+   }
+   if ((source->flags & (SDL_SRCALPHA | SDL_RLEACCEL)) != SDL_SRCALPHA)
+   {
+      return false;
+   }
+   if ((sf->Rmask != df->Rmask) || (sf->Gmask != df->Gmask) || (sf->Bmask != df->Bmask))
+   {
+      return false;
+   }
+
+   int sx = 0, sy = 0;
+   int w = source->w, h = source->h;
+   if (clip != NULL)
+   {
+      sx = clip->x;
+      sy = clip->y;
+      w = clip->w;
+      h = clip->h;
+   }
+   int dx = offset->x, dy = offset->y;
+
+   if (sx < 0)
+   {
+      w += sx;
+      dx -= sx;
+      sx = 0;
+   }
+   if (sy < 0)
+   {
+      h += sy;
+      dy -= sy;
+      sy = 0;
+   }
+   if (sx + w > source->w)
+   {
+      w = source->w - sx;
+   }
+   if (sy + h > source->h)
+   {
+      h = source->h - sy;
+   }
+
+   SDL_Rect &c = destination->clip_rect;
+   if (dx < c.x)
+   {
+      sx += c.x - dx;
+      w -= c.x - dx;
+      dx = c.x;
+   }
+   if (dy < c.y)
+   {
+      sy += c.y - dy;
+      h -= c.y - dy;
+      dy = c.y;
+   }
+   if (dx + w > c.x + c.w)
+   {
+      w = c.x + c.w - dx;
+   }
+   if (dy + h > c.y + c.h)
+   {
+      h = c.y + c.h - dy;
+   }
+
+   if ((w <= 0) || (h <= 0))
+   {
+      offset->w = 0;
+      offset->h = 0;
+      return true;
+   }
+
+   // nothing to draw, but SDL still hands back the area the blit covered
+   int alpha = sf->alpha;
+   if (alpha == SDL_ALPHA_TRANSPARENT)
+   {
+      offset->x = dx;
+      offset->y = dy;
+      offset->w = w;
+      offset->h = h;
+      return true;
+   }
+
+   // a surface's pixels can't be touched unlocked, the source's no more than the destination's
+   if (SDL_MUSTLOCK(source))
+   {
+      if (SDL_LockSurface(source) == -1)
+      {
+         return false;
+      }
+   }
+   if (SDL_MUSTLOCK(destination))
+   {
+      if (SDL_LockSurface(destination) == -1)
+      {
+         if (SDL_MUSTLOCK(source))
+         {
+            SDL_UnlockSurface(source);
+         }
+         return false;
+      }
+   }
+
+   Uint32 keymask = 0, key = 0;
+   if (source->flags & SDL_SRCCOLORKEY)
+   {
+      keymask = 0xFFFFFFFF;
+      key = sf->colorkey;
+   }
+
+   const Uint8 *srcRow = (const Uint8*)source->pixels + sy * source->pitch + sx * 4;
+   Uint8 *dstRow = (Uint8*)destination->pixels + dy * destination->pitch + dx * 4;
+   for (int row = 0; row < h; row++)
+   {
+      if ((alpha == SDL_ALPHA_OPAQUE) && (keymask == 0))
+      {
+         memcpy(dstRow, srcRow, w * 4);
+      }
+      else
+      {
+         alpha_row((const Uint32*)srcRow, (Uint32*)dstRow, w, alpha, key, keymask);
+      }
+      srcRow += source->pitch;
+      dstRow += destination->pitch;
+   }
+
+   if (SDL_MUSTLOCK(destination))
+   {
+      SDL_UnlockSurface(destination);
+   }
+   if (SDL_MUSTLOCK(source))
+   {
+      SDL_UnlockSurface(source);
+   }
+
+   offset->x = dx;
+   offset->y = dy;
+   offset->w = w;
+   offset->h = h;
+   return true;
+}
+
+#endif
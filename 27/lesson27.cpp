@@ -1,10 +1,11 @@
 #include "SDL/SDL.h"
 #include "SDL/SDL_image.h"
-#include "SDL/SDL_ttf.h"
+#include "alpha_blit.h"
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <time.h>
 
 using std::cout;
 
@@ -16,7 +17,6 @@ const int SCREEN_BPP = 32;
 SDL_Surface *front = NULL;
 SDL_Surface *back = NULL;
 SDL_Surface *screen = NULL;
-TTF_Font *font = NULL;
 SDL_Event event;
 
 void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination, SDL_Rect* clip = NULL)
@@ -24,7 +24,10 @@ void apply_surface(int x, int y, SDL_Surface* source, SDL_Surface* destination,
    SDL_Rect offset;
    offset.x = x;
    offset.y = y;
-   SDL_BlitSurface(source, clip, destination, &offset);
+   if (alpha_blit(source, clip, destination, &offset) == false)
+   {
+      SDL_BlitSurface(source, clip, destination, &offset);
+   }
 }
 
 SDL_Surface *load_image(std::string filename)
@@ -42,13 +45,16 @@ SDL_Surface *load_image(std::string filename)
    return optimizedImage;
 }
 
+// Counts on CLOCK_MONOTONIC rather than SDL_GetTicks, so it reads to the
+// nanosecond and never jumps when the wall clock is set.
 class Timer
 {
    private:
-      int startTicks;
-      int pausedTicks;
+      long long startNanos;
+      long long pausedNanos;
       bool paused;
       bool started;
+      static long long now();
    public:
       Timer();
       void start();
@@ -56,23 +62,32 @@ class Timer
       void pause();
       void unpause();
       int get_ticks();
+      long long get_micros();
+      long long get_nanos();
       bool is_started();
       bool is_paused();
 };
 
 Timer::Timer()
 {
-   startTicks = 0;
-   pausedTicks = 0;
+   startNanos = 0;
+   pausedNanos = 0;
    paused = false;
    started = false;
 }
 
+long long Timer::now()
+{
+   timespec time;
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
 void Timer::start()
 {
    started = true;
    paused = false;
-   startTicks = SDL_GetTicks();
+   startNanos = now();
 }
 
 void Timer::stop()
@@ -81,28 +96,39 @@ void Timer::stop()
    paused = false;
 }
 
-int Timer::get_ticks()
+long long Timer::get_nanos()
 {
    if(started == true)
    {
       if (paused == true)
       {
-         return pausedTicks;
+         return pausedNanos;
       }
       else
       {
-         return SDL_GetTicks() - startTicks;
+         return now() - startNanos;
       }
    }
    return 0;
 }
 
+long long Timer::get_micros()
+{
+   return get_nanos() / 1000;
+}
+
+// milliseconds, as SDL_GetTicks counts them
+int Timer::get_ticks()
+{
+   return (int)(get_nanos() / 1000000);
+}
+
 void Timer::pause()
 {
    if ((started == true) && (paused == false))
    {
       paused = true;
-      pausedTicks = SDL_GetTicks() - startTicks;
+      pausedNanos = now() - startNanos;
    }
 }
 
@@ -111,8 +137,8 @@ void Timer::unpause()
    if (paused == true)
    {
       paused = false;
-      startTicks = SDL_GetTicks() - pausedTicks;
-      pausedTicks = 0;
+      startNanos = now() - pausedNanos;
+      pausedNanos = 0;
    }
 }
 
@@ -128,12 +154,7 @@ bool Timer::is_paused()
 
 bool init()
 {
-   if (SDL_Init(SDL_INIT_EVERYTHING) == -1)
-   {
-      return false;
-   }
-
-   if (TTF_Init() == -1)
+   if (SDL_Init(SDL_INIT_VIDEO) == -1)
    {
       return false;
    }
@@ -166,7 +187,6 @@ void clean_up()
 {
    SDL_FreeSurface(back);;
    SDL_FreeSurface(front);;
-   TTF_Quit();
    SDL_Quit();
 }
 
@@ -176,6 +196,15 @@ int main(int argc, char* args[])
 
    int alpha = SDL_ALPHA_OPAQUE;
    Timer fps;
+   Timer update;
+   int frame = 0;
+
+   // "--uncapped" drops the frame cap and shows the frame rate in the caption
+   bool capped = true;
+   if ((argc > 1) && (std::string(args[1]) == "--uncapped"))
+   {
+      capped = false;
+   }
 
    if (init() == false)
    {
@@ -187,6 +216,8 @@ int main(int argc, char* args[])
       return 1;
    }
      
+   update.start();
+
    while(quit == false)
    {
       fps.start();
@@ -218,9 +249,20 @@ int main(int argc, char* args[])
          return 1;
       }
 
-      if (fps.get_ticks() < 1000 / FRAMES_PER_SECOND)
+      frame++;
+      if (update.get_ticks() > 1000)
+      {
+         std::stringstream caption;
+         caption << "Frames Per Second: " << frame / (update.get_micros() / 1000000.f);
+         SDL_WM_SetCaption(caption.str().c_str(), NULL);
+         frame = 0;
+         update.start();
+      }
+
+      long long frameMicros = 1000000 / FRAMES_PER_SECOND;
+      if ((capped == true) && (fps.get_micros() < frameMicros))
       {
-         SDL_Delay((1000/FRAMES_PER_SECOND) - fps.get_ticks());
+         SDL_Delay((frameMicros - fps.get_micros() + 999) / 1000);
       }
 
       while (SDL_PollEvent(&event))